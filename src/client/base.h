@@ -306,6 +306,8 @@ private:
   static std::atomic<uintptr_t> id_counter;
 public:
   static uintptr_t getNextId();
+  // Reserves a contiguous block of ids, returns the first one
+  static uintptr_t getNextIdRange(const uint32_t count);
 };
 
 // The base object for every D3D object. Implements IUnknown::AddRef() and
@@ -362,14 +364,16 @@ protected:
 
   // Constructor for non-standalone D3D objects.
   // Initializes the refcount with the reference to container's refcount
-  // and deleter functor.
+  // and deleter functor. Containers may pass an id reserved up front for
+  // the object, otherwise a new one is allocated.
   template<typename ContainerType>
-  D3DBase(T* pD3DObject, IUnknown* const pDevice, ContainerType* pContainer)
+  D3DBase(T* pD3DObject, IUnknown* const pDevice, ContainerType* pContainer,
+          const uintptr_t id = 0)
     : D3DRefCounted(*pContainer)
     , m_pParent(pContainer)
     , m_type(toD3D9ObjectType<T>())
     , m_standalone(false)
-    , m_id(D3dBaseIdFactory::getNextId()) {
+    , m_id(id != 0 ? id : D3dBaseIdFactory::getNextId()) {
     onConstruct();
   }
 
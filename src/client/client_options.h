@@ -30,6 +30,8 @@
 
 #include <d3d9.h>
 
+#include <algorithm>
+
 namespace ClientOptions {
   inline bool getUseVanillaDxvk() {
     return bridge_util::Config::getOption<bool>("client.useVanillaDxvk", false);
@@ -78,4 +80,63 @@ namespace ClientOptions {
   inline bool getOptimizedDynamicLock() {
     return bridge_util::Config::getOption<bool>("client.optimizedDynamicLock", false);
   }
+
+  // If set, buffer and surface uploads sent through the data queue that are at least
+  // compressUploadsThreshold bytes large are compressed, and decompressed by the server
+  // straight into the locked resource. Uploads that go through the shared heap are not
+  // affected since they are never copied into the queue.
+  inline bool getCompressUploads() {
+    return bridge_util::Config::getOption<bool>("client.compressUploads", false);
+  }
+
+  inline uint32_t getCompressUploadsThreshold() {
+    return bridge_util::Config::getOption<uint32_t>("client.compressUploadsThreshold", 64 * 1024);
+  }
+
+  // Compression is backed off from when the compressed size exceeds this fraction of the
+  // original size, or when compressing runs slower than the given speed in MB/s.
+  inline float getCompressUploadsMaxRatio() {
+    return bridge_util::Config::getOption<float>("client.compressUploadsMaxRatio", 0.8f);
+  }
+
+  inline uint32_t getCompressUploadsMinSpeedMBps() {
+    return bridge_util::Config::getOption<uint32_t>("client.compressUploadsMinSpeedMBps", 400);
+  }
+
+  // If set, stream source, stream frequency, index buffer and vertex declaration/FVF
+  // bindings are not sent one command each but collected, and only the changed slots are
+  // sent to the server in a single command right before the next draw.
+  inline bool getCoalesceInputAssembly() {
+    return bridge_util::Config::getOption<bool>("client.coalesceInputAssembly", true);
+  }
+
+  // If set, SetTransform, MultiplyTransform, SetLight and LightEnable calls are collected
+  // and only the transforms and lights that changed are sent to the server in a single
+  // command right before the next draw.
+  inline bool getCoalesceTransformsAndLights() {
+    return bridge_util::Config::getOption<bool>("client.coalesceTransformsAndLights", true);
+  }
+
+  // If set, consecutive DrawPrimitive and DrawIndexedPrimitive calls are held back and sent
+  // to the server packed into a single command, up to batchDrawsMaxDraws draws at a time.
+  inline bool getBatchDraws() {
+    return bridge_util::Config::getOption<bool>("client.batchDraws", true);
+  }
+
+  inline uint32_t getBatchDrawsMaxDraws() {
+    static const uint32_t maxDraws =
+      std::max(bridge_util::Config::getOption<uint32_t>("client.batchDrawsMaxDraws", 64), 1u);
+    return maxDraws;
+  }
+
+  // If set, the data of unlocked texture levels and cube map faces is held back and sent
+  // to the server in a single command per texture, up to coalesceTextureUploadsMaxKB of
+  // data at a time, before the next command of any other kind.
+  inline bool getCoalesceTextureUploads() {
+    return bridge_util::Config::getOption<bool>("client.coalesceTextureUploads", true);
+  }
+
+  inline uint32_t getCoalesceTextureUploadsMaxKB() {
+    return bridge_util::Config::getOption<uint32_t>("client.coalesceTextureUploadsMaxKB", 4096);
+  }
 }
\ No newline at end of file
@@ -127,17 +127,14 @@ HRESULT Direct3DCubeTexture9_LSS::GetCubeMapSurface(D3DCUBEMAP_FACES FaceType, U
 
     GetLevelDesc(Level, &desc);
 
-    pLssCubeMapSurface = trackWrapper(new Direct3DSurface9_LSS(m_pDevice, this, desc));
+    // The surface id was reserved along with the cube texture, so the server is
+    // able to resolve it on first use without a GetCubeMapSurface command
+    pLssCubeMapSurface = trackWrapper(new Direct3DSurface9_LSS(m_pDevice, this, desc, false,
+                                                               getChildId(surfaceIndex)));
     (*ppCubeMapSurface) = (IDirect3DSurface9*) pLssCubeMapSurface;
 
     setChild(surfaceIndex, pLssCubeMapSurface);
   }
-
-  {
-    ClientMessage c(Commands::IDirect3DCubeTexture9_GetCubeMapSurface, getId());
-    c.send_many(FaceType, Level);
-    c.send_data(pLssCubeMapSurface->getId());
-  }
   return S_OK;
 }
 
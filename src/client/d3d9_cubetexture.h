@@ -33,6 +33,7 @@ public:
   Direct3DCubeTexture9_LSS(BaseDirect3DDevice9Ex_LSS* const pDevice, const TEXTURE_DESC& desc)
     : Direct3DBaseTexture9_LSS(pDevice, desc) {
     m_children.resize(GetLevelCount() * caps::MaxCubeFaces);
+    reserveChildIds();
   }
 
   D3DSURFACE_DESC getLevelDesc(const UINT level) const;
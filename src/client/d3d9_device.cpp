@@ -35,6 +35,10 @@
 #include "d3d9_vertexdeclaration.h"
 #include "d3d9_vertexshader.h"
 #include "d3d9_volumetexture.h"
+#include "draw_batch.h"
+#include "draw_up_allocator.h"
+#include "util_devicestatus.h"
+#include "util_frametimeline.h"
 #include "shadow_map.h"
 #include "client_options.h"
 #include "swapchain_map.h"
@@ -54,8 +58,7 @@
   { \
     ClientMessage c(Commands::IDirect3DDevice9Ex_##func, getId()); \
     currentUID = c.get_uid(); \
-    c.send_many(StartRegister, Count); \
-    c.send_data(size, (void*)pConstantData); \
+    c.send_vectored(StartRegister, Count, DataBlob { size, pConstantData }); \
   }
 
 extern NamedSemaphore* gpPresent;
@@ -67,6 +70,7 @@ void Direct3DDevice9Ex_LSS<EnableSync>::onDestroy() {
   // At this point the underlying d3d9 device's refcount should be 0 and device released
   assert(getRef<D3DRefCounted::Ref::Object>() == 0 &&
          "Destroying an LSS device object with underlying D3D9 object refcount > 0!");
+  releaseGlobalPresentSemaphore();
    ClientMessage c { Commands::IDirect3DDevice9Ex_Destroy, getId() };
 }
 
@@ -99,6 +103,8 @@ void Direct3DDevice9Ex_LSS<EnableSync>::releaseInternalObjects() {
   m_state.vertexShader.reset(nullptr);
   m_state.pixelShader.reset(nullptr);
   m_state.vertexDecl.reset(nullptr);
+  discardInputAssembly();
+  discardTransformsAndLights();
 
   for (uint32_t n = 0; n < implicitRefCnt; n++) {
     D3DBase::Release();
@@ -170,6 +176,12 @@ template<bool EnableSync>
 UINT Direct3DDevice9Ex_LSS<EnableSync>::GetAvailableTextureMem() {
   ZoneScoped;
   LogFunctionCall();
+
+  // Served from the value the server publishes on Present, if up to date
+  uint32_t cachedMem = 0;
+  if (DeviceStatus::isInitialized() && DeviceStatus::getAvailableTextureMem(getId(), cachedMem)) {
+    return cachedMem;
+  }
   
   UID currentUID = 0;
   {
@@ -189,6 +201,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::EvictManagedResources() {
   ZoneScoped;
   LogFunctionCall();
 
+  if (DeviceStatus::isInitialized()) {
+    DeviceStatus::invalidate();
+  }
+
   UID currentUID = 0;
   // Send command to server and wait for response
   {
@@ -265,6 +281,17 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::GetDisplayMode(UINT iSwapChain, D3DDI
   if (pMode == NULL)
     return D3DERR_INVALIDCALL;
 
+  // Implicit swap chain mode is served from the value the server publishes
+  // for this device
+  DeviceStatus::DisplayMode cachedMode;
+  if (iSwapChain == 0 && DeviceStatus::isInitialized() && DeviceStatus::getDisplayMode(getId(), cachedMode)) {
+    pMode->Width = cachedMode.width;
+    pMode->Height = cachedMode.height;
+    pMode->RefreshRate = cachedMode.refreshRate;
+    pMode->Format = (D3DFORMAT) cachedMode.format;
+    return S_OK;
+  }
+
   UID currentUID = 0;
   {
     ClientMessage c(Commands::IDirect3DDevice9Ex_GetDisplayMode, getId());
@@ -335,15 +362,25 @@ BOOL Direct3DDevice9Ex_LSS<EnableSync>::ShowCursor(BOOL bShow) {
   ZoneScoped;
   LogFunctionCall();
 
+  // D3D9 does not count ShowCursor() calls like Win32 does, it simply returns
+  // the previous visibility, so there is no need to ask the server for it
+  BOOL prevShow;
+  {
+    BRIDGE_DEVICE_LOCKGUARD();
+    prevShow = m_bCursorVisible;
+    m_bCursorVisible = bShow ? TRUE : FALSE;
+  }
   UID currentUID = 0;
   {
     ClientMessage c(Commands::IDirect3DDevice9Ex_ShowCursor, getId());
     currentUID = c.get_uid();
     c.send_data(bShow);
   }
-  WAIT_FOR_SERVER_RESPONSE("ShowCursor()", false, currentUID);
-  BOOL prevShow = (BOOL) DeviceBridge::get_data();
-  DeviceBridge::pop_front();
+  if (GlobalOptions::getSendAllServerResponses()) {
+    WAIT_FOR_SERVER_RESPONSE("ShowCursor()", prevShow, currentUID);
+    prevShow = (BOOL) DeviceBridge::get_data();
+    DeviceBridge::pop_front();
+  }
 
   return prevShow;
 }
@@ -425,6 +462,9 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::Reset(D3DPRESENT_PARAMETERS* pPresent
     WndProc::unset();
     WndProc::set(getWinProcHwnd());
     // Tell Server to do the Reset
+    if (DeviceStatus::isInitialized()) {
+      DeviceStatus::invalidate();
+    }
     size_t currentUID = 0;
     {
       ClientMessage c(Commands::IDirect3DDevice9Ex_Reset, getId());
@@ -450,29 +490,51 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::Reset(D3DPRESENT_PARAMETERS* pPresent
   return res;
 }
 
-HRESULT syncOnPresent() {
+HRESULT syncOnPresent(BaseDirect3DDevice9Ex_LSS* const pDevice) {
 #ifdef ENABLE_PRESENT_SEMAPHORE_TRACE
   Logger::trace("Client side Present call received, acquiring semaphore...");
 #endif
 
   // If we're syncing with the server on Present() then wait for the semaphore to be released
   if (GlobalOptions::getPresentSemaphoreEnabled()) {
+    // Frame based recycling is tied to the global semaphore's Present stream.
+    // Since all devices share one command queue it also covers the commands
+    // of devices pacing their Presents with a semaphore of their own.
+    const bool bGlobalPresent = pDevice->usesGlobalPresentSemaphore();
+    if (bGlobalPresent) {
+      DeviceBridge::onPresentSent(GlobalOptions::getPresentSemaphoreMaxFrames());
+    }
+    NamedSemaphore* const pPresent = pDevice->getPresentSemaphore();
     const auto maxRetries = GlobalOptions::getCommandRetries();
     size_t numRetries = 0;
-    while (gbBridgeRunning && RESULT_FAILURE(gpPresent->wait()) && numRetries++ < maxRetries) {
+    while (gbBridgeRunning && RESULT_FAILURE(pPresent->wait()) && numRetries++ < maxRetries) {
       Logger::warn("Still waiting on the Present semaphore to be released...");
     }
     if (numRetries >= maxRetries) {
       Logger::err("Max retries reached waiting on the Present semaphore!");
+      if (bGlobalPresent) {
+        DrawUPAllocator::onPresentUnacknowledged();
+        DeviceBridge::onPresentUnacknowledged();
+      }
       return ERROR_SEM_TIMEOUT;
     } else if (!gbBridgeRunning) {
       Logger::err("Bridge was disabled while waiting on the Present semaphore, aborting current operation!");
+      if (bGlobalPresent) {
+        DrawUPAllocator::onPresentUnacknowledged();
+        DeviceBridge::onPresentUnacknowledged();
+      }
       return ERROR_OPERATION_ABORTED;
 #ifdef ENABLE_PRESENT_SEMAPHORE_TRACE
     } else {
       Logger::trace("Present semaphore acquired successfully.");
 #endif
     }
+    if (bGlobalPresent) {
+      // The server has caught up far enough to recycle the next frame's UP data
+      // and the data queue space used by the frames before it
+      DrawUPAllocator::onPresent();
+      DeviceBridge::onPresentAcknowledged();
+    }
   }
   return S_OK;
 }
@@ -495,6 +557,7 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::Present(CONST RECT* pSourceRect, CONS
   if (!gbBridgeRunning) {
     return hresult;
   }
+  const int64_t presentTime = FrameTimeline::onClientPresent();
 
   if(remixapi::g_bInterfaceInitialized && remixapi::g_presentCallback) {
     remixapi::g_presentCallback();
@@ -507,13 +570,14 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::Present(CONST RECT* pSourceRect, CONS
     // Send present first
     {
       ClientMessage c(Commands::IDirect3DDevice9Ex_Present, getId());
-      c.send_data(sizeof(RECT), (void*) pSourceRect);
-      c.send_data(sizeof(RECT), (void*) pDestRect);
-      c.send_data((uint32_t) hDestWindowOverride);
-      c.send_data(sizeof(RGNDATA), (void*) pDirtyRegion);
+      FrameTimeline::onClientPresentSent(presentTime);
+      c.send_vectored(DataBlob { sizeof(RECT), pSourceRect },
+                      DataBlob { sizeof(RECT), pDestRect },
+                      (uint32_t) hDestWindowOverride,
+                      DataBlob { sizeof(RGNDATA), pDirtyRegion });
     }
 
-    const auto syncResult = syncOnPresent();
+    const auto syncResult = syncOnPresent(this);
     if (syncResult == ERROR_SEM_TIMEOUT) {
       return ERROR_SEM_TIMEOUT;
     }
@@ -604,6 +668,7 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::CreateTexture(UINT Width, UINT Height
       ClientMessage c(Commands::IDirect3DDevice9Ex_CreateTexture, getId());
       currentUID = c.get_uid();
       c.send_many(Width, Height, Levels, Usage, Format, Pool, (uint32_t) pLssTexture->getId());
+      c.send_many((uint32_t) pLssTexture->getFirstChildId(), pLssTexture->getNumChildren());
     }
   }
   WAIT_FOR_OPTIONAL_CREATE_FUNCTION_SERVER_RESPONSE("CreateTexture()", D3DERR_INVALIDCALL, currentUID);
@@ -632,6 +697,7 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::CreateVolumeTexture(UINT Width, UINT
       ClientMessage c(Commands::IDirect3DDevice9Ex_CreateVolumeTexture, getId());
       currentUID = c.get_uid();
       c.send_many(Width, Height, Depth, Levels, Usage, Format, Pool, (uint32_t) pLssVolumeTexture->getId());
+      c.send_many((uint32_t) pLssVolumeTexture->getFirstChildId(), pLssVolumeTexture->getNumChildren());
     }
   }
   WAIT_FOR_OPTIONAL_CREATE_FUNCTION_SERVER_RESPONSE("CreateVolumeTexture()", D3DERR_INVALIDCALL, currentUID);
@@ -660,6 +726,7 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::CreateCubeTexture(UINT EdgeLength, UI
       ClientMessage c(Commands::IDirect3DDevice9Ex_CreateCubeTexture, getId());
       currentUID = c.get_uid();
       c.send_many(EdgeLength, Levels, Usage, Format, Pool, (uint32_t) pLssCubeTexture->getId());
+      c.send_many((uint32_t) pLssCubeTexture->getFirstChildId(), pLssCubeTexture->getNumChildren());
     }
   }
   WAIT_FOR_OPTIONAL_CREATE_FUNCTION_SERVER_RESPONSE("CreateCubeTexture()", D3DERR_INVALIDCALL, currentUID);
@@ -1151,11 +1218,11 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::Clear(DWORD Count, CONST D3DRECT* pRe
   {
     ClientMessage c(Commands::IDirect3DDevice9Ex_Clear, getId());
     currentUID = c.get_uid();
-    c.send_many(Count, Flags);
-    c.send_data(sizeof(float), &Z);
-    c.send_data(Stencil);
-    c.send_data(sizeof(D3DRECT) * Count, (void*) pRects);
-    c.send_data(sizeof(D3DCOLOR), (void*) &Color);
+    c.send_vectored(Count, Flags,
+                    DataBlob { sizeof(float), &Z },
+                    Stencil,
+                    DataBlob { sizeof(D3DRECT) * Count, pRects },
+                    DataBlob { sizeof(D3DCOLOR), &Color });
   }
   WAIT_FOR_OPTIONAL_SERVER_RESPONSE("Clear()", D3DERR_INVALIDCALL, currentUID);
 }
@@ -1208,17 +1275,21 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetTransform(D3DTRANSFORMSTATETYPE St
       if (m_stateRecording) {
         if (GlobalOptions::getEliminateRedundantSetterCalls() &&
             m_stateRecording->m_dirtyFlags.transforms[idx] &&
-            memcmp(&m_stateRecording->m_captureState.transforms[idx], pMatrix, sizeof(D3DMATRIX)) == 0) {
+            IsMatrixEqual(m_stateRecording->m_captureState.transforms[idx], *pMatrix)) {
           return S_OK;
         }
         m_stateRecording->m_captureState.transforms[idx] = *pMatrix;
         m_stateRecording->m_dirtyFlags.transforms[idx] = true;
       } else {
         if (GlobalOptions::getEliminateRedundantSetterCalls() &&
-            memcmp(&m_state.transforms[idx], pMatrix, sizeof(D3DMATRIX)) == 0) {
+            IsMatrixEqual(m_state.transforms[idx], *pMatrix)) {
           return S_OK;
         }
         m_state.transforms[idx] = *pMatrix;
+        if (canCoalesceTransformsAndLights()) {
+          coalesceTransform(State, idx);
+          return S_OK;
+        }
       }
     }
     {
@@ -1257,6 +1328,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::MultiplyTransform(D3DTRANSFORMSTATETY
     return D3DERR_INVALIDCALL;
   }
 
+  if (!isValidD3drtansformstatetype(State)) {
+    return D3DERR_INVALIDCALL;
+  }
+
   BRIDGE_DEVICE_LOCKGUARD();
   const auto idx = mapXformStateTypeToIdx(State);
   D3DMATRIX result = { 0 };
@@ -1272,14 +1347,8 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::MultiplyTransform(D3DTRANSFORMSTATETY
     }
   }
 
-  if (m_stateRecording) {
-    m_stateRecording->m_captureState.transforms[idx] = result;
-    m_stateRecording->m_dirtyFlags.transforms[idx] = true;
-  } else {
-    m_state.transforms[idx] = result;
-  }
-  
-  return S_OK;
+  // The server does not implement MultiplyTransform, so the product is set instead
+  return SetTransform(State, &result);
 }
 
 template<bool EnableSync>
@@ -1377,7 +1446,7 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetLight(DWORD Index, CONST D3DLIGHT9
   ZoneScoped;
   LogFunctionCall();
 
-  if (pLight == nullptr) {
+  if (pLight == nullptr || !LightSlots<D3DLIGHT9>::isValidIndex(Index)) {
     return D3DERR_INVALIDCALL;
   }
 
@@ -1399,6 +1468,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetLight(DWORD Index, CONST D3DLIGHT9
           return S_OK;
         }
         m_state.lights[Index] = *pLight;
+        if (canCoalesceTransformsAndLights()) {
+          coalesceLight(Index);
+          return S_OK;
+        }
       }
     }
     {
@@ -1422,7 +1495,11 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::GetLight(DWORD Index, D3DLIGHT9* pLig
 
   {
     BRIDGE_DEVICE_LOCKGUARD();
-    *pLight = m_state.lights[Index];
+    const D3DLIGHT9* const pSlot = m_state.lights.find(Index);
+    if (pSlot == nullptr) {
+      return D3DERR_INVALIDCALL;
+    }
+    *pLight = *pSlot;
   }
   return S_OK;
 }
@@ -1432,6 +1509,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::LightEnable(DWORD LightIndex, BOOL bE
   ZoneScoped;
   LogFunctionCall();
 
+  if (!LightSlots<bool>::isValidIndex(LightIndex)) {
+    return D3DERR_INVALIDCALL;
+  }
+
   UID currentUID = 0;
   {
     {
@@ -1450,6 +1531,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::LightEnable(DWORD LightIndex, BOOL bE
           return S_OK;
         }
         m_state.bLightEnables[LightIndex] = bEnable;
+        if (canCoalesceTransformsAndLights()) {
+          coalesceLightEnable(LightIndex);
+          return S_OK;
+        }
       }
     }
     {
@@ -1473,7 +1558,11 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::GetLightEnable(DWORD Index, BOOL* pEn
     BRIDGE_DEVICE_LOCKGUARD();
     // This is the true value for light-enables found through experimentation
     constexpr BOOL LightEnableTrue = 128;
-    *pEnable = m_state.bLightEnables[Index] ? LightEnableTrue : 0;
+    const bool* const pSlot = m_state.bLightEnables.find(Index);
+    if (pSlot == nullptr) {
+      return D3DERR_INVALIDCALL;
+    }
+    *pEnable = *pSlot ? LightEnableTrue : 0;
   }
   return S_OK;
 }
@@ -1778,6 +1867,8 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::CreateStateBlock(D3DSTATEBLOCKTYPE Ty
     return D3DERR_INVALIDCALL;
   }
 
+  flushCoalescedState();
+
   UID currentUID = 0;
   {
     
@@ -1809,6 +1900,8 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::BeginStateBlock() {
     if (m_stateRecording) {
       return D3DERR_INVALIDCALL;
     }
+    // State set before recording began must not end up in the state block
+    flushCoalescedState();
     m_stateRecording = trackWrapper(new Direct3DStateBlock9_LSS(this));
   }
   UID currentUID = 0;
@@ -2296,6 +2389,14 @@ template<bool EnableSync>
 HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetSoftwareVertexProcessing(BOOL bSoftware) {
   ZoneScoped;
   LogFunctionCall();
+
+  // Software vertex processing can only be switched on for devices created
+  // with mixed or software vertex processing, mirror that locally rather than
+  // waiting on the server to reject it
+  constexpr DWORD kSwvpBehaviorFlags = D3DCREATE_MIXED_VERTEXPROCESSING | D3DCREATE_SOFTWARE_VERTEXPROCESSING;
+  if (bSoftware && (m_createParams.BehaviorFlags & kSwvpBehaviorFlags) == 0) {
+    return D3DERR_INVALIDCALL;
+  }
   {
     BRIDGE_DEVICE_LOCKGUARD();
     m_bSoftwareVtxProcessing = bSoftware;
@@ -2306,10 +2407,7 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetSoftwareVertexProcessing(BOOL bSof
     currentUID = c.get_uid();
     c.send_data(bSoftware);
   }
-  WAIT_FOR_SERVER_RESPONSE("SetSoftwareVertexProcessing()", D3DERR_INVALIDCALL, currentUID);
-
-  HRESULT hresult = DeviceBridge::get_data();
-  return hresult;
+  WAIT_FOR_OPTIONAL_SERVER_RESPONSE("SetSoftwareVertexProcessing()", D3DERR_INVALIDCALL, currentUID);
 }
 
 template<bool EnableSync>
@@ -2358,6 +2456,11 @@ template<bool EnableSync>
 HRESULT Direct3DDevice9Ex_LSS<EnableSync>::DrawPrimitive(D3DPRIMITIVETYPE PrimitiveType, UINT StartVertex, UINT PrimitiveCount) {
   ZoneScoped;
   LogFunctionCall();
+  if (DrawBatch::isEnabled()) {
+    batchDraw(Commands::MultiDrawPrimitive, { (uint32_t) PrimitiveType, StartVertex, PrimitiveCount });
+    return D3D_OK;
+  }
+  flushCoalescedState();
   UID currentUID = 0;
   {
     ClientMessage c(Commands::IDirect3DDevice9Ex_DrawPrimitive, getId());
@@ -2371,6 +2474,12 @@ template<bool EnableSync>
 HRESULT Direct3DDevice9Ex_LSS<EnableSync>::DrawIndexedPrimitive(D3DPRIMITIVETYPE Type, INT BaseVertexIndex, UINT MinVertexIndex, UINT NumVertices, UINT startIndex, UINT primCount) {
   ZoneScoped;
   LogFunctionCall();
+  if (DrawBatch::isEnabled()) {
+    batchDraw(Commands::MultiDrawIndexedPrimitive,
+              { (uint32_t) Type, (uint32_t) BaseVertexIndex, MinVertexIndex, NumVertices, startIndex, primCount });
+    return D3D_OK;
+  }
+  flushCoalescedState();
   UID currentUID = 0;
   {
     ClientMessage c(Commands::IDirect3DDevice9Ex_DrawIndexedPrimitive, getId());
@@ -2384,17 +2493,31 @@ template<bool EnableSync>
 HRESULT Direct3DDevice9Ex_LSS<EnableSync>::DrawPrimitiveUP(D3DPRIMITIVETYPE PrimitiveType, UINT PrimitiveCount, CONST void* pVertexStreamZeroData, UINT VertexStreamZeroStride) {
   ZoneScoped;
   LogFunctionCall();
+  flushCoalescedState();
   UID currentUID = 0;
   {
-    ClientMessage c(Commands::IDirect3DDevice9Ex_DrawPrimitiveUP, getId());
-    currentUID = c.get_uid();
-    c.send_many(PrimitiveType, PrimitiveCount);
-
     uint32_t numIndices = GetIndexCount(PrimitiveType, PrimitiveCount);
     uint32_t vertexDataSize = numIndices * VertexStreamZeroStride;
 
-    c.send_data(vertexDataSize, (void*) pVertexStreamZeroData);
-    c.send_data(VertexStreamZeroStride);
+    // Place the vertex data into the shared heap if possible, this needs to
+    // happen before the command is opened since it may send commands itself
+    DrawUPAllocator::Allocation vertexAlloc;
+    const bool bUseSharedHeap = DrawUPAllocator::isEnabled() &&
+                                DrawUPAllocator::allocate(vertexDataSize, vertexAlloc);
+    if (bUseSharedHeap) {
+      memcpy(vertexAlloc.ptr, pVertexStreamZeroData, vertexDataSize);
+    }
+
+    ClientMessage c(Commands::IDirect3DDevice9Ex_DrawPrimitiveUP, getId(),
+                    bUseSharedHeap ? Commands::FlagBits::DataInSharedHeap : 0);
+    currentUID = c.get_uid();
+    if (bUseSharedHeap) {
+      c.send_many(PrimitiveType, PrimitiveCount, vertexAlloc.allocId, vertexAlloc.offset, VertexStreamZeroStride);
+    } else {
+      c.send_vectored(PrimitiveType, PrimitiveCount,
+                      DataBlob { vertexDataSize, pVertexStreamZeroData },
+                      VertexStreamZeroStride);
+    }
   }
   WAIT_FOR_OPTIONAL_SERVER_RESPONSE("DrawPrimitiveUP()", D3DERR_INVALIDCALL, currentUID);
 }
@@ -2403,19 +2526,39 @@ template<bool EnableSync>
 HRESULT Direct3DDevice9Ex_LSS<EnableSync>::DrawIndexedPrimitiveUP(D3DPRIMITIVETYPE PrimitiveType, UINT MinIndex, UINT NumVertices, UINT PrimitiveCount, CONST void* pIndexData, D3DFORMAT IndexDataFormat, CONST void* pVertexStreamZeroData, UINT VertexStreamZeroStride) {
   ZoneScoped;
   LogFunctionCall();
+  flushCoalescedState();
   UID currentUID = 0;
   {
-    ClientMessage c(Commands::IDirect3DDevice9Ex_DrawIndexedPrimitiveUP, getId());
-    currentUID = c.get_uid();
-    c.send_many(PrimitiveType, MinIndex, NumVertices, PrimitiveCount, IndexDataFormat, VertexStreamZeroStride);
-
     uint32_t numIndices = GetIndexCount(PrimitiveType, PrimitiveCount);
     uint32_t indexStride = IndexDataFormat == D3DFMT_INDEX16 ? 2 : 4;
     uint32_t indexDataSize = numIndices * indexStride;
     uint32_t vertexDataSize = NumVertices * VertexStreamZeroStride;
 
-    c.send_data(indexDataSize, (void*) pIndexData);
-    c.send_data(vertexDataSize, (void*) pVertexStreamZeroData);
+    // Place index and vertex data into the shared heap if possible, this needs
+    // to happen before the command is opened since it may send commands itself
+    DrawUPAllocator::Allocation indexAlloc;
+    DrawUPAllocator::Allocation vertexAlloc;
+    const bool bUseSharedHeap = DrawUPAllocator::isEnabled() &&
+                                DrawUPAllocator::allocate(indexDataSize + vertexDataSize, indexAlloc);
+    if (bUseSharedHeap) {
+      vertexAlloc.allocId = indexAlloc.allocId;
+      vertexAlloc.offset = indexAlloc.offset + indexDataSize;
+      vertexAlloc.ptr = static_cast<uint8_t*>(indexAlloc.ptr) + indexDataSize;
+      memcpy(indexAlloc.ptr, pIndexData, indexDataSize);
+      memcpy(vertexAlloc.ptr, pVertexStreamZeroData, vertexDataSize);
+    }
+
+    ClientMessage c(Commands::IDirect3DDevice9Ex_DrawIndexedPrimitiveUP, getId(),
+                    bUseSharedHeap ? Commands::FlagBits::DataInSharedHeap : 0);
+    currentUID = c.get_uid();
+    if (bUseSharedHeap) {
+      c.send_many(PrimitiveType, MinIndex, NumVertices, PrimitiveCount, IndexDataFormat, VertexStreamZeroStride,
+                  indexAlloc.allocId, indexAlloc.offset, vertexAlloc.offset);
+    } else {
+      c.send_vectored(PrimitiveType, MinIndex, NumVertices, PrimitiveCount, IndexDataFormat, VertexStreamZeroStride,
+                      DataBlob { indexDataSize, pIndexData },
+                      DataBlob { vertexDataSize, pVertexStreamZeroData });
+    }
   }
   WAIT_FOR_OPTIONAL_SERVER_RESPONSE("DrawIndexedPrimitiveUP()", D3DERR_INVALIDCALL, currentUID);
 }
@@ -2435,6 +2578,8 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::ProcessVertices(UINT SrcStartIndex, U
   auto* const pLssDestBuffer = bridge_cast<Direct3DVertexBuffer9_LSS*>(pDestBuffer);
   const UID destBufferId = (pLssDestBuffer) ? (UID) pLssDestBuffer->getId() : 0;
 
+  flushCoalescedState();
+
   // Send command to server and wait for response
   UID currentUID = 0;
   {
@@ -2471,9 +2616,9 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::CreateVertexDeclaration(CONST D3DVERT
     {
       ClientMessage c(Commands::IDirect3DDevice9Ex_CreateVertexDeclaration, getId());
       currentUID = c.get_uid();
-      c.send_data(numElem);
-      c.send_data(sizeof(D3DVERTEXELEMENT9) * numElem, (void*) pStart);
-      c.send_data((uint32_t) pLssVtxDecl->getId());
+      c.send_vectored(numElem,
+                      DataBlob { sizeof(D3DVERTEXELEMENT9) * numElem, pStart },
+                      (uint32_t) pLssVtxDecl->getId());
     }
   }
   WAIT_FOR_OPTIONAL_CREATE_FUNCTION_SERVER_RESPONSE("CreateVertexDeclaration()", D3DERR_INVALIDCALL, currentUID);
@@ -2491,6 +2636,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetVertexDeclaration(IDirect3DVertexD
     {
       BRIDGE_DEVICE_LOCKGUARD();
       m_state.vertexDecl = MakeD3DAutoPtr(pLssVtxDecl);
+      if (canCoalesceInputAssembly()) {
+        coalesceVertexDeclaration((uint32_t) id);
+        return S_OK;
+      }
     }
     {
       ClientMessage c(Commands::IDirect3DDevice9Ex_SetVertexDeclaration, getId());
@@ -2530,6 +2679,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetFVF(DWORD FVF) {
     {
       BRIDGE_DEVICE_LOCKGUARD();
       m_FVF = FVF;
+      if (canCoalesceInputAssembly()) {
+        coalesceFVF(FVF);
+        return S_OK;
+      }
     }
     {
       ClientMessage c(Commands::IDirect3DDevice9Ex_SetFVF, getId());
@@ -2827,6 +2980,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetStreamSource(UINT StreamNumber, ID
           m_state.streamOffsets[StreamNumber] = OffsetInBytes;
           m_state.streamStrides[StreamNumber] = Stride;
         }
+        if (canCoalesceInputAssembly()) {
+          coalesceStreamSource(StreamNumber, (uint32_t) id, OffsetInBytes, Stride);
+          return S_OK;
+        }
       }
     }
     {
@@ -2873,6 +3030,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetStreamSourceFreq(UINT StreamNumber
         m_stateRecording->m_dirtyFlags.streamFreqs[StreamNumber] = true;
       } else {
         m_state.streamFreqs[StreamNumber] = Divider;
+        if (canCoalesceInputAssembly()) {
+          coalesceStreamSourceFreq(StreamNumber, Divider);
+          return S_OK;
+        }
       }
     }
     {
@@ -2913,6 +3074,10 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::SetIndices(IDirect3DIndexBuffer9* pIn
         m_stateRecording->m_dirtyFlags.indices = true;
       } else {
         m_state.indices = MakeD3DAutoPtr(pLssIndexData);
+        if (canCoalesceInputAssembly()) {
+          coalesceIndices((uint32_t) id);
+          return S_OK;
+        }
       }
     }
     {
@@ -3321,6 +3486,16 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::CheckDeviceState(HWND hDestinationWin
   ZoneScoped;
   LogFunctionCall();
 
+  // The server publishes the state of the device window on every Present,
+  // which is what games polling this each frame are after
+  const bool isDeviceWindow = hDestinationWindow == nullptr ||
+                              hDestinationWindow == getPresentationHwnd() ||
+                              hDestinationWindow == getFocusHwnd();
+  uint32_t deviceState = 0;
+  if (isDeviceWindow && DeviceStatus::isInitialized() && DeviceStatus::getDeviceState(getId(), deviceState)) {
+    return (HRESULT) deviceState;
+  }
+
   UID currentUID = 0;
   // Send command to server and wait for response
   {
@@ -3443,6 +3618,11 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::ResetEx(D3DPRESENT_PARAMETERS* pPrese
   ZoneScoped;
   assert(m_ex);
   LogMissingFunctionCall();
+  // The app expects the display mode and cooperative level to change, so
+  // stop answering those queries from the cache
+  if (DeviceStatus::isInitialized()) {
+    DeviceStatus::invalidate();
+  }
   return D3D_OK;
 }
 
@@ -3455,7 +3635,18 @@ HRESULT Direct3DDevice9Ex_LSS<EnableSync>::GetDisplayModeEx(UINT iSwapChain, D3D
   if (pMode == NULL || pRotation == NULL)
     return D3DERR_INVALIDCALL;
 
-  
+  DeviceStatus::DisplayMode cachedMode;
+  if (iSwapChain == 0 && DeviceStatus::isInitialized() && DeviceStatus::getDisplayMode(getId(), cachedMode)) {
+    pMode->Size = sizeof(D3DDISPLAYMODEEX);
+    pMode->Width = cachedMode.width;
+    pMode->Height = cachedMode.height;
+    pMode->RefreshRate = cachedMode.refreshRate;
+    pMode->Format = (D3DFORMAT) cachedMode.format;
+    pMode->ScanLineOrdering = (D3DSCANLINEORDERING) cachedMode.scanLineOrdering;
+    *pRotation = (D3DDISPLAYROTATION) cachedMode.rotation;
+    return S_OK;
+  }
+
   UID currentUID = 0;
   {
     ClientMessage c(Commands::IDirect3DDevice9Ex_GetDisplayModeEx, getId());
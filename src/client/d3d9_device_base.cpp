@@ -21,13 +21,29 @@
  */
 #include "d3d9_device_base.h"
 
+#include "client_options.h"
 #include "d3d9_lss.h"
+#include "draw_batch.h"
+#include "upload_batch.h"
 #include "window.h"
 
 #include "util_modulecommand.h"
 
 #include <d3d9.h>
 
+#include <algorithm>
+
+extern NamedSemaphore* gpPresent;
+
+// Held uploads always predate the held draws, see UploadBatch::begin(), so
+// they go first and the draws must not be sent while they are being sent
+static void flushHeldCommands() {
+  UploadBatch::flush();
+  if (!UploadBatch::isFlushing()) {
+    DrawBatch::flush();
+  }
+}
+
 BaseDirect3DDevice9Ex_LSS::BaseDirect3DDevice9Ex_LSS(const bool bExtended,
                                                      Direct3D9Ex_LSS* const pDirect3D,
                                                      const D3DDEVICE_CREATION_PARAMETERS& createParams,
@@ -78,7 +94,23 @@ BaseDirect3DDevice9Ex_LSS::BaseDirect3DDevice9Ex_LSS(const bool bExtended,
   m_bSoftwareVtxProcessing = (createParams.BehaviorFlags & D3DCREATE_SOFTWARE_VERTEXPROCESSING) ? true : false;
   DWORD customBehaviorFlags = createParams.BehaviorFlags | D3DCREATE_NOWINDOWCHANGES;
   InitRamp();
+
+  // Coalesced bindings would never be acknowledged individually
+  m_bCoalesceInputAssembly = ClientOptions::getCoalesceInputAssembly() &&
+                             !GlobalOptions::getSendAllServerResponses();
+  m_bCoalesceTransformsAndLights = ClientOptions::getCoalesceTransformsAndLights() &&
+                                   !GlobalOptions::getSendAllServerResponses();
+  if (DrawBatch::isEnabled() || UploadBatch::isEnabled()) {
+    DeviceBridge::setFlushHeldCommands(&flushHeldCommands);
+  }
   
+  // Claim the global Present semaphore if no other device is using it
+  bool bOwnPresentSemaphore = false;
+  if (GlobalOptions::getPresentSemaphoreEnabled()) {
+    const BaseDirect3DDevice9Ex_LSS* pExpected = nullptr;
+    bOwnPresentSemaphore = !s_pGlobalPresentOwner.compare_exchange_strong(pExpected, this);
+  }
+
   UID currentUID = 0;
   {
     ClientMessage c(m_ex ? Commands::IDirect3D9Ex_CreateDeviceEx : Commands::IDirect3D9Ex_CreateDevice, getId());
@@ -94,12 +126,14 @@ BaseDirect3DDevice9Ex_LSS::BaseDirect3DDevice9Ex_LSS(const bool bExtended,
       c.send_data(sizeof(D3DDISPLAYMODEEX), pFullscreenDisplayMode);
     }
     c.send_data(sizeof(D3DPRESENT_PARAMETERS), &m_presParams);
+    c.send_data((uint32_t) bOwnPresentSemaphore);
   }
   Logger::debug("...server-side D3D9 device creation command sent...");
 
   Logger::debug("...waiting for create device ack response from server...");
   if (Result::Success != DeviceBridge::waitForCommand(Commands::Bridge_Response, 0, nullptr, true, currentUID)) {
     Logger::err("...server-side D3D9 device creation failed with: no response from server.");
+    releaseGlobalPresentSemaphore();
     WndProc::unset();
     hresultOut = D3DERR_DEVICELOST;
     return;
@@ -114,13 +148,191 @@ BaseDirect3DDevice9Ex_LSS::BaseDirect3DDevice9Ex_LSS(const bool bExtended,
   if (FAILED(hresultOut)) {
     Logger::err(format_string("...server-side D3D9 device creation failed with %x.", hresultOut));
     // Release client device and report server error to the app
+    releaseGlobalPresentSemaphore();
     WndProc::unset();
     return;
   }
+  if (bOwnPresentSemaphore) {
+    // Created by the server before it responded, so the initial count is the server's
+    const auto maxFrames = GlobalOptions::getPresentSemaphoreMaxFrames();
+    m_pPresentSemaphore = std::make_unique<NamedSemaphore>(format_string("Present%u", (uint32_t) getId()), 0, maxFrames);
+  }
   Logger::debug("...server-side D3D9 device successfully created...");
   Logger::debug("...Device successfully created!");
 }
 
+NamedSemaphore* BaseDirect3DDevice9Ex_LSS::getPresentSemaphore() const {
+  return m_pPresentSemaphore ? m_pPresentSemaphore.get() : gpPresent;
+}
+
+void BaseDirect3DDevice9Ex_LSS::releaseGlobalPresentSemaphore() {
+  const BaseDirect3DDevice9Ex_LSS* pExpected = this;
+  s_pGlobalPresentOwner.compare_exchange_strong(pExpected, nullptr);
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceStreamSource(const uint32_t streamNumber, const uint32_t id,
+                                                     const uint32_t offset, const uint32_t stride) {
+  m_pendingInputAssembly.streams[streamNumber] = { id, offset, stride };
+  m_pendingInputAssembly.streamMask |= 1 << streamNumber;
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceStreamSourceFreq(const uint32_t streamNumber, const uint32_t divider) {
+  m_pendingInputAssembly.streamFreqs[streamNumber] = divider;
+  m_pendingInputAssembly.streamFreqMask |= 1 << streamNumber;
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceIndices(const uint32_t id) {
+  m_pendingInputAssembly.indices = id;
+  m_pendingInputAssembly.flags |= Commands::IndicesChanged;
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceVertexDeclaration(const uint32_t id) {
+  // Declaration and FVF share the same slot on the device, last one set wins
+  m_pendingInputAssembly.vertexDecl = id;
+  m_pendingInputAssembly.flags &= ~Commands::FVFChanged;
+  m_pendingInputAssembly.flags |= Commands::VertexDeclChanged;
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceFVF(const DWORD FVF) {
+  m_pendingInputAssembly.FVF = FVF;
+  m_pendingInputAssembly.flags &= ~Commands::VertexDeclChanged;
+  m_pendingInputAssembly.flags |= Commands::FVFChanged;
+}
+
+void BaseDirect3DDevice9Ex_LSS::discardInputAssembly() {
+  m_pendingInputAssembly.streamMask = 0;
+  m_pendingInputAssembly.streamFreqMask = 0;
+  m_pendingInputAssembly.flags = 0;
+}
+
+bool BaseDirect3DDevice9Ex_LSS::encodeInputAssembly(std::vector<uint32_t>& words) {
+  const auto& pending = m_pendingInputAssembly;
+  if (pending.streamMask == 0 && pending.streamFreqMask == 0 && pending.flags == 0) {
+    return false;
+  }
+  words.push_back(pending.streamMask);
+  words.push_back(pending.streamFreqMask);
+  words.push_back(pending.flags);
+  for (uint32_t i = 0; i < caps::MaxStreams; ++i) {
+    if (pending.streamMask & (1 << i)) {
+      const auto& stream = pending.streams[i];
+      words.insert(words.end(), { stream.id, stream.offset, stream.stride });
+    }
+  }
+  for (uint32_t i = 0; i < caps::MaxStreams; ++i) {
+    if (pending.streamFreqMask & (1 << i)) {
+      words.push_back(pending.streamFreqs[i]);
+    }
+  }
+  if (pending.flags & Commands::IndicesChanged) {
+    words.push_back(pending.indices);
+  }
+  if (pending.flags & Commands::VertexDeclChanged) {
+    words.push_back(pending.vertexDecl);
+  } else if (pending.flags & Commands::FVFChanged) {
+    words.push_back(pending.FVF);
+  }
+  discardInputAssembly();
+  return true;
+}
+
+void BaseDirect3DDevice9Ex_LSS::batchDraw(const uint32_t op, std::initializer_list<uint32_t> args) {
+  BRIDGE_BASE_DEVICE_LOCKGUARD();
+  auto& words = DrawBatch::begin(getId());
+  const size_t opIndex = words.size();
+  words.push_back(op);
+  if (encodeInputAssembly(words)) {
+    words[opIndex] |= Commands::MultiDrawInputAssembly;
+  }
+  if (encodeTransformsAndLights(words)) {
+    words[opIndex] |= Commands::MultiDrawTransformsAndLights;
+  }
+  words.insert(words.end(), args);
+  DrawBatch::end();
+}
+
+void BaseDirect3DDevice9Ex_LSS::flushInputAssembly() {
+  BRIDGE_BASE_DEVICE_LOCKGUARD();
+  m_inputAssemblyWords.clear();
+  if (!encodeInputAssembly(m_inputAssemblyWords)) {
+    return;
+  }
+  {
+    ClientMessage c(Commands::IDirect3DDevice9Ex_SetInputAssembly, getId());
+    c.send_data(m_inputAssemblyWords.size() * sizeof(uint32_t), m_inputAssemblyWords.data());
+  }
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceTransform(const D3DTRANSFORMSTATETYPE state, const size_t idx) {
+  auto& pending = m_pendingTransformsAndLights;
+  if (!pending.transformMask.test(idx)) {
+    pending.transformMask.set(idx);
+    pending.transforms.push_back({ state, idx });
+  }
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceLight(const DWORD index) {
+  auto& lights = m_pendingTransformsAndLights.lights;
+  if (std::find(lights.begin(), lights.end(), index) == lights.end()) {
+    lights.push_back(index);
+  }
+}
+
+void BaseDirect3DDevice9Ex_LSS::coalesceLightEnable(const DWORD index) {
+  auto& lightEnables = m_pendingTransformsAndLights.lightEnables;
+  if (std::find(lightEnables.begin(), lightEnables.end(), index) == lightEnables.end()) {
+    lightEnables.push_back(index);
+  }
+}
+
+bool BaseDirect3DDevice9Ex_LSS::encodeTransformsAndLights(std::vector<uint32_t>& words) {
+  static_assert(sizeof(D3DMATRIX) % sizeof(uint32_t) == 0);
+  static_assert(sizeof(D3DLIGHT9) % sizeof(uint32_t) == 0);
+  const auto& pending = m_pendingTransformsAndLights;
+  if (pending.transforms.empty() && pending.lights.empty() && pending.lightEnables.empty()) {
+    return false;
+  }
+  words.push_back((uint32_t) pending.transforms.size());
+  words.push_back((uint32_t) pending.lights.size());
+  words.push_back((uint32_t) pending.lightEnables.size());
+  for (const auto& transform : pending.transforms) {
+    const auto* const pMatrix = reinterpret_cast<const uint32_t*>(&m_state.transforms[transform.idx]);
+    words.push_back((uint32_t) transform.state);
+    words.insert(words.end(), pMatrix, pMatrix + sizeof(D3DMATRIX) / sizeof(uint32_t));
+  }
+  for (const DWORD index : pending.lights) {
+    const auto* const pLight = reinterpret_cast<const uint32_t*>(&m_state.lights[index]);
+    words.push_back(index);
+    words.insert(words.end(), pLight, pLight + sizeof(D3DLIGHT9) / sizeof(uint32_t));
+  }
+  for (const DWORD index : pending.lightEnables) {
+    words.push_back(index);
+    words.push_back(m_state.bLightEnables[index] ? TRUE : FALSE);
+  }
+  discardTransformsAndLights();
+  return true;
+}
+
+void BaseDirect3DDevice9Ex_LSS::discardTransformsAndLights() {
+  auto& pending = m_pendingTransformsAndLights;
+  pending.transformMask.reset();
+  pending.transforms.clear();
+  pending.lights.clear();
+  pending.lightEnables.clear();
+}
+
+void BaseDirect3DDevice9Ex_LSS::flushTransformsAndLights() {
+  BRIDGE_BASE_DEVICE_LOCKGUARD();
+  m_transformsAndLightsWords.clear();
+  if (!encodeTransformsAndLights(m_transformsAndLightsWords)) {
+    return;
+  }
+  {
+    ClientMessage c(Commands::IDirect3DDevice9Ex_SetTransformsAndLights, getId());
+    c.send_data(m_transformsAndLightsWords.size() * sizeof(uint32_t), m_transformsAndLightsWords.data());
+  }
+}
+
 void BaseDirect3DDevice9Ex_LSS::InitRamp() {
   for (uint32_t i = 0; i < NumControlPoints; i++) {
     DWORD identity = DWORD(MapGammaControlPoint(float(i) / float(NumControlPoints - 1)));
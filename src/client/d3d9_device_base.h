@@ -23,12 +23,18 @@
 
 #include "util_common.h"
 #include "util_scopedlock.h"
+#include "util_semaphore.h"
 
 #include "d3d9.h"
 #include "base.h"
 #include "shadow_map.h"
 
 #include <array>
+#include <bitset>
+#include <initializer_list>
+#include <atomic>
+#include <memory>
+#include <vector>
 
 class Direct3D9Ex_LSS;
 class Direct3DSwapChain9_LSS;
@@ -66,6 +72,64 @@ public:
     return m_previousPresentParams;
   }
 
+  // Semaphore pacing this device's Presents. The first device alive uses the
+  // global Present semaphore, any other device gets one of its own so that
+  // e.g. a tool window device presenting at its own rate does not eat into
+  // the main device's frames in flight.
+  bridge_util::NamedSemaphore* getPresentSemaphore() const;
+
+  bool usesGlobalPresentSemaphore() const {
+    return !m_pPresentSemaphore;
+  }
+
+  // Sends the input assembly bindings and the transforms and lights coalesced since the
+  // last flush, if any. Must be called before sending any command that consumes or
+  // captures this state on the server, i.e. draws and state block commands.
+  void flushCoalescedState() {
+    flushInputAssembly();
+    flushTransformsAndLights();
+  }
+
+  // Light state indexed directly by light slot. D3D9 allows any light index, so slots
+  // are allocated up to the highest index used, like DXVK does. Setters must check
+  // isValidIndex() before growing the slots, getters must use find().
+  template<typename T>
+  class LightSlots {
+  public:
+    // Bounds the memory a single call can make the slots grow to
+    static constexpr DWORD kMaxSlots = 1 << 16;
+
+    static bool isValidIndex(const DWORD index) {
+      return index < kMaxSlots;
+    }
+
+    // Grows the slots up to the index if needed
+    T& operator[](const DWORD index) {
+      assert(isValidIndex(index));
+      if (index >= m_slots.size()) {
+        m_slots.resize(index + 1);
+      }
+      return m_slots[index].value;
+    }
+    const T& operator[](const DWORD index) const {
+      static const T kDefault{};
+      return index < m_slots.size() ? m_slots[index].value : kDefault;
+    }
+    // Returns nullptr if the slot was never allocated
+    const T* find(const DWORD index) const {
+      return index < m_slots.size() ? &m_slots[index].value : nullptr;
+    }
+    size_t size() const {
+      return m_slots.size();
+    }
+  private:
+    // Wrapped so that bools are not packed by std::vector
+    struct Slot {
+      T value{};
+    };
+    std::vector<Slot> m_slots;
+  };
+
   struct ShaderConstants {
     template<typename T>
     struct Vec4 {
@@ -146,6 +210,44 @@ protected:
   HWND getWinProcHwnd() const { return getPresentationHwnd() ? getPresentationHwnd() : getFocusHwnd(); }
 
   void InitRamp();
+
+  // Gives up the global Present semaphore if this device was pacing it
+  void releaseGlobalPresentSemaphore();
+
+  // Input assembly bindings are rebound before nearly every draw, so rather than sending
+  // a command per Set* call they are collected here while not recording a state block.
+  bool canCoalesceInputAssembly() const {
+    return m_bCoalesceInputAssembly && m_stateRecording == nullptr;
+  }
+  void coalesceStreamSource(const uint32_t streamNumber, const uint32_t id,
+                            const uint32_t offset, const uint32_t stride);
+  void coalesceStreamSourceFreq(const uint32_t streamNumber, const uint32_t divider);
+  void coalesceIndices(const uint32_t id);
+  void coalesceVertexDeclaration(const uint32_t id);
+  void coalesceFVF(const DWORD FVF);
+  // Appends the coalesced bindings, if there are any, to the given words in the layout
+  // expected by the server and clears them.
+  bool encodeInputAssembly(std::vector<uint32_t>& words);
+  // Drops coalesced bindings, e.g. when a Reset restores the defaults anyway
+  void discardInputAssembly();
+  void flushInputAssembly();
+
+  // Fixed-function titles set their matrices and lights per draw, so like the input
+  // assembly bindings these are collected and sent in a single delta packet.
+  bool canCoalesceTransformsAndLights() const {
+    return m_bCoalesceTransformsAndLights && m_stateRecording == nullptr;
+  }
+  void coalesceTransform(const D3DTRANSFORMSTATETYPE state, const size_t idx);
+  void coalesceLight(const DWORD index);
+  void coalesceLightEnable(const DWORD index);
+  // Appends the changed transforms and lights, read from the current state, to the
+  // given words in the layout expected by the server and clears them.
+  bool encodeTransformsAndLights(std::vector<uint32_t>& words);
+  void discardTransformsAndLights();
+  void flushTransformsAndLights();
+
+  // Packs a draw, along with any coalesced state, into the current DrawBatch
+  void batchDraw(const uint32_t op, std::initializer_list<uint32_t> args);
   
   using ShaderType = ShaderConstants::ShaderType;
   using ConstantType = ShaderConstants::ConstantType;
@@ -186,11 +288,46 @@ protected:
   std::unordered_map<UINT, PALETTEENTRY> m_paletteEntries;
   UINT m_curTexPalette;
   BOOL m_bSoftwareVtxProcessing;
+  // Emulated on the client, the server cursor state only ever follows it
+  BOOL m_bCursorVisible = FALSE;
   D3DCLIPSTATUS9 m_clipStatus;
   float m_NPatchMode;
   DWORD m_FVF;
   INT m_gpuThreadPriority;
   UINT m_maxFrameLatency;
+  std::unique_ptr<bridge_util::NamedSemaphore> m_pPresentSemaphore;
+  inline static std::atomic<const BaseDirect3DDevice9Ex_LSS*> s_pGlobalPresentOwner = nullptr;
+
+  bool m_bCoalesceInputAssembly = false;
+  struct PendingInputAssembly {
+    struct StreamBinding {
+      uint32_t id;
+      uint32_t offset;
+      uint32_t stride;
+    };
+    uint32_t streamMask = 0;
+    uint32_t streamFreqMask = 0;
+    uint32_t flags = 0; // Commands::InputAssemblyBits
+    std::array<StreamBinding, caps::MaxStreams> streams;
+    std::array<uint32_t, caps::MaxStreams> streamFreqs;
+    uint32_t indices = 0;
+    uint32_t vertexDecl = 0;
+    DWORD FVF = 0;
+  } m_pendingInputAssembly;
+  std::vector<uint32_t> m_inputAssemblyWords;
+
+  bool m_bCoalesceTransformsAndLights = false;
+  struct PendingTransformsAndLights {
+    struct Transform {
+      D3DTRANSFORMSTATETYPE state;
+      size_t idx;
+    };
+    std::bitset<caps::MaxTransforms> transformMask;
+    std::vector<Transform> transforms;
+    std::vector<DWORD> lights;
+    std::vector<DWORD> lightEnables;
+  } m_pendingTransformsAndLights;
+  std::vector<uint32_t> m_transformsAndLightsWords;
 
   struct StateCaptureDirtyFlags {
     // Vertex Decl
@@ -214,9 +351,9 @@ protected:
     // Material
     bool material;
     // Lights
-    std::unordered_map<DWORD, bool> lights;
+    LightSlots<bool> lights;
     // Light Enables
-    std::unordered_map<DWORD, bool> bLightEnables;
+    LightSlots<bool> bLightEnables;
     // Transforms
     std::array<bool, caps::MaxTransforms> transforms;
     // Texture Stage State
@@ -252,9 +389,9 @@ protected:
     // Material
     D3DMATERIAL9 material;
     // Lights
-    std::unordered_map<DWORD, D3DLIGHT9> lights;
+    LightSlots<D3DLIGHT9> lights;
     // Light Enables
-    std::unordered_map<DWORD, bool> bLightEnables;
+    LightSlots<bool> bLightEnables;
     // Clip Plane
     std::array<float[4], caps::MaxClipPlanes> clipPlanes;
     // Render State
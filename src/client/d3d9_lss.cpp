@@ -40,10 +40,14 @@
 
 #include "util_bridge_assert.h"
 #include "util_bridge_state.h"
+#include "util_commandhistory.h"
 #include "util_common.h"
 #include "util_devicecommand.h"
+#include "util_devicestatus.h"
 #include "util_modulecommand.h"
+#include "util_phasetimer.h"
 #include "util_filesys.h"
+#include "util_frametimeline.h"
 #include "util_hack_d3d_debug.h"
 #include "util_messagechannel.h"
 #include "util_seh.h"
@@ -61,6 +65,9 @@ std::atomic<uintptr_t> D3dBaseIdFactory::id_counter = 1;
 uintptr_t D3dBaseIdFactory::getNextId() {
   return id_counter++;
 }
+uintptr_t D3dBaseIdFactory::getNextIdRange(const uint32_t count) {
+  return id_counter.fetch_add(count);
+}
 
 #if defined(_DEBUG) || defined(DEBUGOPT)
 
@@ -133,6 +140,7 @@ void PrintRecentCommandHistory() {
   ModuleBridge::Command::print_writer_data_sent();
   Logger::info("Most recent Module Queue commands received by Server");
   ModuleBridge::Command::print_writer_data_received();
+  CommandHistory::dump();
 }
 
 // Setup bridge exception handler if requested
@@ -176,8 +184,19 @@ void InitServer() {
   cmdSS << " " << BRIDGE_VERSION;
   cmdSS << " " << std::string(GetCommandLineA());
   const std::string command = cmdSS.str();
-  gpServer = new Process(command.c_str(), OnServerExited);
+  {
+    ScopedPhaseTimer timer("Launching server process");
+    gpServer = new Process(command.c_str(), OnServerExited);
+  }
 
+  BridgeState::setServerState(BridgeState::ProcessState::Init);
+
+  // Initialize our shared queue as a Reader.
+  Logger::info("Sending SYN command, waiting for ACK from server...");
+  ClientMessage { Commands::Bridge_Syn, (uintptr_t) gpServer->GetCurrentProcessHandle() };
+
+  // The server needs a while to load d3d9.dll, so take care of any client-only
+  // setup now, while we would otherwise just be waiting for the ACK
   if (ClientOptions::getEnableDpiAwareness()) {
     Logger::info("Process set as DPI aware");
     static HINSTANCE shcore_dll = ::LoadLibraryA("shcore.dll");
@@ -195,14 +214,12 @@ void InitServer() {
     }
   }
 
-  BridgeState::setServerState(BridgeState::ProcessState::Init);
-
-  // Initialize our shared queue as a Reader.
-  Logger::info("Sending SYN command, waiting for ACK from server...");
-  ClientMessage { Commands::Bridge_Syn, (uintptr_t) gpServer->GetCurrentProcessHandle() };
-
   BridgeState::setClientState(BridgeState::ProcessState::Handshaking);
-  const auto waitForAckResult = DeviceBridge::waitForCommand(Commands::Bridge_Ack, GlobalOptions::getStartupTimeout());
+  Result waitForAckResult;
+  {
+    ScopedPhaseTimer timer("Waiting for server ACK");
+    waitForAckResult = DeviceBridge::waitForCommand(Commands::Bridge_Ack, GlobalOptions::getStartupTimeout());
+  }
   switch (waitForAckResult) {
   case Result::Timeout:
   {
@@ -252,8 +269,13 @@ void InitServer() {
   BridgeState::setServerState(BridgeState::ProcessState::Running);
   
   if (GlobalOptions::getUseSharedHeap()) {
+    ScopedPhaseTimer timer("SharedHeap initialization");
     SharedHeap::init();
   }
+
+  const auto timeServerReady = std::chrono::high_resolution_clock::now();
+  Logger::info(format_string("[Startup] Bridge ready after %.2f ms",
+    std::chrono::duration_cast<std::chrono::microseconds>(timeServerReady - gTimeStart).count() / 1000.0));
 }
 
 bool InitRemixFolder(HMODULE hinst) {
@@ -406,6 +428,14 @@ bool RemixAttach(HMODULE hModule) {
 
     gpPresent = new NamedSemaphore("Present", 0, GlobalOptions::getPresentSemaphoreMaxFrames());
 
+    if (GlobalOptions::getCacheDeviceStatus()) {
+      DeviceStatus::init();
+    }
+
+    if (GlobalOptions::getFrameTimeline()) {
+      FrameTimeline::init();
+    }
+
     BridgeState::setClientState(BridgeState::ProcessState::Init);
 
     // Deprecated config options, will be removed in future versions!!!
@@ -57,8 +57,9 @@ public:
   template<typename ContainerType>
   Direct3DResource9_LSS(T* const pResource,
                         BaseDirect3DDevice9Ex_LSS* const pDevice,
-                        ContainerType* const pContainer)
-    : D3DBase(pResource, pDevice, pContainer)
+                        ContainerType* const pContainer,
+                        const uintptr_t id = 0)
+    : D3DBase(pResource, pDevice, pContainer, id)
     , m_pDevice(pDevice) {
   }
 
@@ -179,6 +180,32 @@ protected:
     m_children[idx] = child;
   }
 
+  // Reserves ids for all children up front. The server derives the children
+  // from these ids on first use, so child objects may be created on the
+  // client without notifying the server. Must be called once the number of
+  // children is known.
+  inline void reserveChildIds() {
+    assert(m_childIdBase == 0 && "Child ids may be only reserved once!");
+    m_childIdBase = D3dBaseIdFactory::getNextIdRange((uint32_t) m_children.size());
+  }
+
+  inline uintptr_t getChildId(uint32_t idx) const {
+    assert(m_childIdBase != 0 && "Child ids were not reserved!");
+    assert(idx < m_children.size() && "Child index overrun!");
+    return m_childIdBase + idx;
+  }
+
+public:
+  inline uintptr_t getFirstChildId() const {
+    return m_childIdBase;
+  }
+
+  inline uint32_t getNumChildren() const {
+    return (uint32_t) m_children.size();
+  }
+
+protected:
   BaseDirect3DDevice9Ex_LSS* const m_pDevice;
   std::vector<ChildType*> m_children;
+  uintptr_t m_childIdBase = 0;
 };
@@ -119,11 +119,15 @@ void Direct3DStateBlock9_LSS::StateTransfer(const BaseDirect3DDevice9Ex_LSS::Sta
   if (flags.material) {
     dst.material = src.material;
   }
-  for (const auto& [key, value] : flags.lights) {
-    dst.lights[key] = src.lights[key];
+  for (DWORD i = 0; i < flags.lights.size(); i++) {
+    if (flags.lights[i]) {
+      dst.lights[i] = src.lights[i];
+    }
   }
-  for (const auto& [key, value] : flags.bLightEnables) {
-    dst.bLightEnables[key] = src.bLightEnables[key];
+  for (DWORD i = 0; i < flags.bLightEnables.size(); i++) {
+    if (flags.bLightEnables[i]) {
+      dst.bLightEnables[i] = src.bLightEnables[i];
+    }
   }
   for (int i = 0; i < flags.transforms.size(); i++) {
     if (flags.transforms[i]) {
@@ -200,6 +204,7 @@ HRESULT Direct3DStateBlock9_LSS::Capture() {
     return D3DERR_INVALIDCALL;
   }
   LocalCapture();
+  m_pDevice->flushCoalescedState();
   {
     ClientMessage { Commands::IDirect3DStateBlock9_Capture, getId() };
   }
@@ -209,6 +214,7 @@ HRESULT Direct3DStateBlock9_LSS::Capture() {
 HRESULT Direct3DStateBlock9_LSS::Apply() {
   LogFunctionCall();
   StateTransfer(m_dirtyFlags, m_captureState, m_pDevice->m_state);
+  m_pDevice->flushCoalescedState();
   {
     ClientMessage { Commands::IDirect3DStateBlock9_Apply, getId() };
   }
@@ -28,6 +28,8 @@
 #include "d3d9_cubetexture.h"
 
 #include "d3d9_surfacebuffer_helper.h"
+#include "upload_batch.h"
+#include "upload_compressor.h"
 #include "util_bridge_assert.h"
 #include "util_gdi.h"
 
@@ -261,8 +263,57 @@ void* Direct3DSurface9_LSS::getBufPtr(const int pitch, const RECT& rect) {
   return ptr;
 }
 
+bool Direct3DSurface9_LSS::holdDataForUpload(const LockInfo& lockInfo) const {
+  // Only texture levels and cube faces are coalesced, uploads through the
+  // shared heap never go through the data queue to begin with
+  if (m_textureId == 0 || m_bUseSharedHeap || !UploadBatch::isEnabled()) {
+    return false;
+  }
+  const auto [width, height] = getRectDimensions(lockInfo.rect);
+  const size_t totalSize = bridge_util::calcTotalSizeOfRect(width, height, m_desc.Format);
+  const uint32_t rowSize = bridge_util::calcRowSize(width, m_desc.Format);
+  uint8_t* pRows = UploadBatch::begin(m_textureId, getId(), lockInfo.rect, lockInfo.flags,
+                                      m_desc.Format, rowSize, totalSize);
+  if (pRows == nullptr) {
+    return false;
+  }
+  FOR_EACH_RECT_ROW(lockInfo.lockedRect, height, m_desc.Format, {
+    memcpy(pRows, ptr, rowSize);
+    pRows += rowSize;
+  });
+  UploadBatch::end();
+  return true;
+}
+
 void Direct3DSurface9_LSS::sendDataToServer(const LockInfo& lockInfo) const {
-  const auto dataFlag = m_bUseSharedHeap ? Commands::FlagBits::DataInSharedHeap : 0;
+  if (holdDataForUpload(lockInfo)) {
+    return;
+  }
+
+  auto dataFlag = m_bUseSharedHeap ? Commands::FlagBits::DataInSharedHeap : 0;
+
+  // Compress the rect rows up front if worthwhile, as the ClientMessage
+  // below must not be held open while doing so
+  const void* pCompressed = nullptr;
+  size_t compressedSize = 0;
+  if (!m_bUseSharedHeap && UploadCompressor::isEnabled()) {
+    const auto [width, height] = getRectDimensions(lockInfo.rect);
+    const size_t totalSize = bridge_util::calcTotalSizeOfRect(width, height, m_desc.Format);
+    const size_t rowSize = bridge_util::calcRowSize(width, m_desc.Format);
+    const void* pRows = lockInfo.lockedRect.pBits;
+    if ((size_t) lockInfo.lockedRect.Pitch != rowSize) {
+      uint8_t* gatherPtr = UploadCompressor::getGatherBuffer(totalSize);
+      pRows = gatherPtr;
+      FOR_EACH_RECT_ROW(lockInfo.lockedRect, height, m_desc.Format, {
+        memcpy(gatherPtr, ptr, rowSize);
+        gatherPtr += rowSize;
+      });
+    }
+    if (UploadCompressor::compress(pRows, totalSize, pCompressed, compressedSize)) {
+      dataFlag = Commands::FlagBits::DataIsCompressed;
+    }
+  }
+
   {
     ClientMessage c(Commands::IDirect3DSurface9_UnlockRect, getId(), dataFlag);
     c.send_data(sizeof(RECT), &lockInfo.rect);
@@ -276,7 +327,9 @@ void Direct3DSurface9_LSS::sendDataToServer(const LockInfo& lockInfo) const {
       const size_t totalSize = bridge_util::calcTotalSizeOfRect(width, height, m_desc.Format);
       const size_t rowSize = bridge_util::calcRowSize(width, m_desc.Format);
       c.send_data(rowSize);
-      if (auto* blobPacketPtr = c.begin_data_blob(totalSize)) {
+      if (pCompressed) {
+        c.send_data(compressedSize, pCompressed);
+      } else if (auto* blobPacketPtr = c.begin_data_blob(totalSize)) {
         FOR_EACH_RECT_ROW(lockInfo.lockedRect, height, m_desc.Format, {
           memcpy(blobPacketPtr, ptr, rowSize);
           blobPacketPtr += rowSize;
@@ -37,6 +37,8 @@ class Direct3DSurface9_LSS: public Direct3DResource9_LSS<IDirect3DSurface9> {
 
   const D3DSURFACE_DESC m_desc;
   const bool m_bUseSharedHeap = false;
+  // Handle of the texture or cube texture owning this surface, if any
+  const uintptr_t m_textureId = 0;
   gdi::D3DKMT_DESTROYDCFROMMEMORY m_dcDesc;
   SharedHeap::AllocId m_bufferId = SharedHeap::kInvalidId;
   struct LockInfo {
@@ -60,9 +62,11 @@ public:
   Direct3DSurface9_LSS(BaseDirect3DDevice9Ex_LSS* const pDevice,
                        ContainerType* const pContainer,
                        const D3DSURFACE_DESC& desc, 
-                       bool isBackBuffer = false)
-    : Direct3DResource9_LSS((IDirect3DSurface9*)nullptr, pDevice, pContainer)
+                       bool isBackBuffer = false,
+                       const uintptr_t id = 0)
+    : Direct3DResource9_LSS((IDirect3DSurface9*)nullptr, pDevice, pContainer, id)
     , m_bUseSharedHeap(GlobalOptions::getUseSharedHeapForTextures())
+    , m_textureId(isBackBuffer ? 0 : pContainer->getId())
     , m_desc(desc)
     , m_isBackBuffer(isBackBuffer) {
   }
@@ -98,5 +102,6 @@ private:
   static RECT resolveLockInfoRect(const RECT* const pRect, const D3DSURFACE_DESC& desc);
   void* getBufPtr(const int pitch, const RECT& rect);
   void sendDataToServer(const LockInfo& lockInfo) const;
+  bool holdDataForUpload(const LockInfo& lockInfo) const;
   static std::tuple<size_t, size_t> getRectDimensions(const RECT& box);
 };
\ No newline at end of file
@@ -25,6 +25,8 @@
 #include "d3d9_surface.h"
 #include "d3d9_surfacebuffer_helper.h"
 #include "swapchain_map.h"
+#include "util_devicestatus.h"
+#include "util_frametimeline.h"
 
 extern std::mutex gSwapChainMapMutex;
 extern SwapChainMap gSwapChainMap;
@@ -167,19 +169,21 @@ HRESULT Direct3DSwapChain9_LSS::Present(CONST RECT* pSourceRect, CONST RECT* pDe
   if (!gbBridgeRunning) {
     return D3D_OK;
   }
+  const int64_t presentTime = FrameTimeline::onClientPresent();
 
   // Send present first
   {
     ClientMessage c(Commands::IDirect3DSwapChain9_Present, getId());
-    c.send_data(sizeof(RECT), (void*) pSourceRect);
-    c.send_data(sizeof(RECT), (void*) pDestRect);
-    c.send_data((uint32_t) hDestWindowOverride);
-    c.send_data(sizeof(RGNDATA), (void*) pDirtyRegion);
-    c.send_data(dwFlags);
+    FrameTimeline::onClientPresentSent(presentTime);
+    c.send_vectored(DataBlob { sizeof(RECT), pSourceRect },
+                    DataBlob { sizeof(RECT), pDestRect },
+                    (uint32_t) hDestWindowOverride,
+                    DataBlob { sizeof(RGNDATA), pDirtyRegion },
+                    dwFlags);
   }
 
-  extern HRESULT syncOnPresent();
-  const auto syncResult = syncOnPresent();
+  extern HRESULT syncOnPresent(BaseDirect3DDevice9Ex_LSS* const pDevice);
+  const auto syncResult = syncOnPresent(m_pDevice);
   if (syncResult == ERROR_SEM_TIMEOUT) {
     return ERROR_SEM_TIMEOUT;
   }
@@ -263,10 +267,20 @@ HRESULT Direct3DSwapChain9_LSS::GetRasterStatus(D3DRASTER_STATUS* pRasterStatus)
   if (pRasterStatus == nullptr)
     return D3DERR_INVALIDCALL;
 
-  D3DDISPLAYMODEEX mode;
-  mode.Size = sizeof(mode);
-  if (m_pDevice->GetDisplayModeEx(0, &mode, nullptr) != S_OK)
+  // Polled in tight loops by some games, so the display mode comes from the
+  // cache the server publishes for the owning device whenever possible
+  // instead of a round trip.
+  D3DDISPLAYMODE mode;
+  DeviceStatus::DisplayMode cachedMode;
+  if (DeviceStatus::isInitialized() && DeviceStatus::getDisplayMode(m_pDevice->getId(), cachedMode)) {
+    mode.Height = cachedMode.height;
+    mode.RefreshRate = cachedMode.refreshRate;
+  } else if (m_pDevice->GetDisplayMode(0, &mode) != S_OK) {
     return D3DERR_INVALIDCALL;
+  }
+
+  if (mode.RefreshRate == 0)
+    mode.RefreshRate = 60;
 
   uint32_t scanLineCount = mode.Height + vBlankLineCount;
 
@@ -120,17 +120,13 @@ HRESULT Direct3DTexture9_LSS::GetSurfaceLevel(UINT Level, IDirect3DSurface9** pp
   D3DSURFACE_DESC desc;
   GetLevelDesc(Level, &desc);
 
-  Direct3DSurface9_LSS* pLssSurface = trackWrapper(new Direct3DSurface9_LSS(m_pDevice, this, desc));
+  // The surface id was reserved along with the texture, so the server is able
+  // to resolve it on first use without a GetSurfaceLevel command
+  Direct3DSurface9_LSS* pLssSurface =
+    trackWrapper(new Direct3DSurface9_LSS(m_pDevice, this, desc, false, getChildId(Level)));
   setChild(Level, pLssSurface);
     
   (*ppSurfaceLevel) = pLssSurface;
-
-  // Add handles for both the texture and surface
-  {
-    ClientMessage c(Commands::IDirect3DTexture9_GetSurfaceLevel, getId());
-    c.send_data(Level);
-    c.send_data(pLssSurface->getId());
-  }
   
   return S_OK;
 }
@@ -37,6 +37,7 @@ public:
   Direct3DTexture9_LSS(BaseDirect3DDevice9Ex_LSS* const pDevice, const TEXTURE_DESC& desc)
     : Direct3DBaseTexture9_LSS(pDevice, desc) {
     m_children.resize(GetLevelCount());
+    reserveChildIds();
   }
 
   D3DSURFACE_DESC getLevelDesc(const UINT level) const;
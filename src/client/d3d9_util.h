@@ -36,6 +36,7 @@
 #include <array>
 #include <optional>
 #include <assert.h>
+#include <emmintrin.h>
 #include <windowsx.h>
 #include <d3d9types.h>
 #include <stack>
@@ -100,6 +101,17 @@ static uint32_t GetIndexCount(D3DPRIMITIVETYPE type, UINT count) {
   }
 }
 
+// Bitwise matrix comparison, same as memcmp() == 0 but with four 16-byte compares
+static inline bool IsMatrixEqual(const D3DMATRIX& a, const D3DMATRIX& b) {
+  const __m128i* const pA = reinterpret_cast<const __m128i*>(&a);
+  const __m128i* const pB = reinterpret_cast<const __m128i*>(&b);
+  __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(pA), _mm_loadu_si128(pB));
+  for (int i = 1; i < 4; ++i) {
+    eq = _mm_and_si128(eq, _mm_cmpeq_epi32(_mm_loadu_si128(pA + i), _mm_loadu_si128(pB + i)));
+  }
+  return _mm_movemask_epi8(eq) == 0xffff;
+}
+
 static void SetWindowMode(HWND hwnd, const bool windowed, const LONG width, const LONG height) {
   if (hwnd == 0) {
     hwnd = ::GetForegroundWindow(); // Get current window
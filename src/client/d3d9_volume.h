@@ -46,8 +46,9 @@ public:
   template<typename ContainerType>
   Direct3DVolume9_LSS(BaseDirect3DDevice9Ex_LSS* const pDevice,
                       ContainerType* const pContainerVolumeTexture,
-                      const D3DVOLUME_DESC& desc)
-    : D3DBase((IDirect3DVolume9*) nullptr, pDevice, pContainerVolumeTexture)
+                      const D3DVOLUME_DESC& desc,
+                      const uintptr_t id = 0)
+    : D3DBase((IDirect3DVolume9*) nullptr, pDevice, pContainerVolumeTexture, id)
     , m_pDevice(pDevice)
     , m_desc(desc) {
   }
@@ -117,17 +117,13 @@ HRESULT Direct3DVolumeTexture9_LSS::GetVolumeLevel(UINT Level, IDirect3DVolume9*
       D3DVOLUME_DESC desc;
       GetLevelDesc(Level, &desc);
 
-      pLssVolume = trackWrapper(new Direct3DVolume9_LSS(m_pDevice, this, desc));
+      // The volume id was reserved along with the volume texture, so the server
+      // is able to resolve it on first use without a GetVolumeLevel command
+      pLssVolume = trackWrapper(new Direct3DVolume9_LSS(m_pDevice, this, desc, getChildId(Level)));
       setChild(Level, pLssVolume);
     }
 
     (*ppVolumeLevel) = pLssVolume;
-
-    {
-      ClientMessage c(Commands::IDirect3DVolumeTexture9_GetVolumeLevel, getId());
-      c.send_data(Level);
-      c.send_data((uint32_t) pLssVolume->getId());
-    }
   }
   return S_OK;
 }
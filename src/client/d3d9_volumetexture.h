@@ -31,6 +31,7 @@ public:
   Direct3DVolumeTexture9_LSS(BaseDirect3DDevice9Ex_LSS* const pDevice, const TEXTURE_DESC& desc)
     : Direct3DBaseTexture9_LSS(pDevice, desc) {
     m_children.resize(GetLevelCount());
+    reserveChildIds();
   }
 
   /*** IUnknown methods ***/
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "client_options.h"
+#include "util_devicecommand.h"
+
+#include <mutex>
+#include <vector>
+
+// Packs runs of DrawPrimitive/DrawIndexedPrimitive calls, along with the
+// input assembly bindings changed in between, into a single MultiDraw
+// command that the server decodes draw by draw.
+//
+// Held draws are flushed before any other command is started, through the
+// device bridge's held commands callback, so the command order seen by the
+// server is unchanged. A run also ends when it reaches the configured number
+// of draws or when another device draws.
+class DrawBatch {
+public:
+  static bool isEnabled() {
+    // Batched draws cannot be acknowledged one by one
+    static const bool bEnabled = ClientOptions::getBatchDraws() &&
+                                 !GlobalOptions::getSendAllServerResponses();
+    return bEnabled;
+  }
+
+  // Starts packing a draw of the given device and returns the words to
+  // append it to. Must be followed by end().
+  static std::vector<uint32_t>& begin(const uintptr_t deviceHandle) {
+    s_mutex.lock();
+    if (s_numDraws > 0 && deviceHandle != s_deviceHandle) {
+      flush();
+    }
+    s_deviceHandle = deviceHandle;
+    return s_words;
+  }
+
+  static void end() {
+    if (++s_numDraws >= ClientOptions::getBatchDrawsMaxDraws()) {
+      flush();
+    }
+    s_mutex.unlock();
+  }
+
+  // Sends the held draws, if any
+  static void flush() {
+    std::scoped_lock lock(s_mutex);
+    // Sending the batch starts a command which calls back into here
+    if (s_numDraws == 0 || s_bFlushing) {
+      return;
+    }
+    s_bFlushing = true;
+    s_pfnSend(s_deviceHandle, s_numDraws, s_words);
+    s_words.clear();
+    s_numDraws = 0;
+    s_bFlushing = false;
+  }
+
+  // Sends one batch. Replaceable so that the batching can be tested without
+  // a server on the other end of the queue.
+  using SendFn = void(*)(uintptr_t deviceHandle, uint32_t numDraws, const std::vector<uint32_t>& words);
+  static void setSend(SendFn pfnSend) {
+    s_pfnSend = pfnSend;
+  }
+
+private:
+  static void send(const uintptr_t deviceHandle, const uint32_t numDraws, const std::vector<uint32_t>& words) {
+    ClientMessage c(Commands::IDirect3DDevice9Ex_MultiDraw, deviceHandle);
+    c.send_data(numDraws);
+    c.send_data((uint32_t) (words.size() * sizeof(uint32_t)), words.data());
+  }
+
+  static inline std::recursive_mutex s_mutex;
+  static inline std::vector<uint32_t> s_words;
+  static inline uint32_t s_numDraws = 0;
+  static inline uintptr_t s_deviceHandle = 0;
+  static inline bool s_bFlushing = false;
+  static inline SendFn s_pfnSend = &send;
+};
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "config/global_options.h"
+#include "util_common.h"
+#include "util_sharedheap.h"
+
+#include <mutex>
+#include <vector>
+
+// Linear allocator carving DrawPrimitiveUP/DrawIndexedPrimitiveUP data out
+// of per-frame shared heap allocations, so that the server can read the
+// vertices and indices in place instead of pulling them off the data queue.
+//
+// There is one allocation per frame that may be in flight, plus the one
+// currently being recorded. Once the Present semaphore has been acquired for
+// a frame, the server is guaranteed to have processed the Present of the
+// frame that used the next slot, so it can be recycled without any further
+// synchronization. A Present whose semaphore wait failed leaves the semaphore
+// a release ahead for good, after which every acquire only vouches for a frame
+// one further back, so each of those adds a slot to the ring.
+class DrawUPAllocator {
+public:
+  struct Allocation {
+    bridge_util::SharedHeap::AllocId allocId = bridge_util::SharedHeap::kInvalidId;
+    uint32_t offset = 0;
+    void* ptr = nullptr;
+  };
+
+  static bool isEnabled() {
+    return GlobalOptions::getUseSharedHeapForDrawUP();
+  }
+
+  // Returns false if the data does not fit into the current frame's
+  // allocation, in which case the caller must fall back to the data queue.
+  static bool allocate(const uint32_t size, Allocation& allocation) {
+    std::scoped_lock lock(s_mutex);
+    const uint32_t alignedSize = bridge_util::align<uint32_t>(size, kAlignment);
+    if (s_offset + alignedSize > GlobalOptions::getSharedHeapDrawUPFrameSize()) {
+      return false;
+    }
+    if (s_frames.empty()) {
+      s_frames.resize(GlobalOptions::getPresentSemaphoreMaxFrames() + 1 + s_numUnacknowledgedPresents,
+                      bridge_util::SharedHeap::kInvalidId);
+    }
+    auto& frameAllocId = s_frames[s_curFrame];
+    if (frameAllocId == bridge_util::SharedHeap::kInvalidId) {
+      frameAllocId = bridge_util::SharedHeap::allocate(GlobalOptions::getSharedHeapDrawUPFrameSize());
+      if (frameAllocId == bridge_util::SharedHeap::kInvalidId) {
+        return false;
+      }
+    }
+    allocation.allocId = frameAllocId;
+    allocation.offset = s_offset;
+    allocation.ptr = bridge_util::SharedHeap::getBuf(frameAllocId) + s_offset;
+    s_offset += alignedSize;
+    return true;
+  }
+
+  // Must only be called once the Present semaphore has been acquired.
+  static void onPresent() {
+    std::scoped_lock lock(s_mutex);
+    if (!s_frames.empty()) {
+      s_curFrame = (s_curFrame + 1) % s_frames.size();
+    }
+    s_offset = 0;
+  }
+
+  // Called instead of onPresent() when the Present semaphore wait failed.
+  static void onPresentUnacknowledged() {
+    std::scoped_lock lock(s_mutex);
+    ++s_numUnacknowledgedPresents;
+    if (!s_frames.empty()) {
+      // The new slot is the next one recorded into, which pushes the frames
+      // still in flight one Present further from being recycled
+      s_frames.insert(s_frames.begin() + s_curFrame + 1, bridge_util::SharedHeap::kInvalidId);
+    }
+  }
+
+private:
+  static constexpr uint32_t kAlignment = 16;
+  static inline std::mutex s_mutex;
+  static inline std::vector<bridge_util::SharedHeap::AllocId> s_frames;
+  static inline size_t s_curFrame = 0;
+  static inline uint32_t s_offset = 0;
+  static inline uint32_t s_numUnacknowledgedPresents = 0;
+};
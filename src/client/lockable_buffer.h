@@ -25,6 +25,7 @@
 #include "util_sharedheap.h"
 
 #include "d3d9_util.h"
+#include "upload_compressor.h"
 
 #include <d3d9.h>
 #include <queue>
@@ -192,6 +193,8 @@ protected:
     if ((lockInfo.flags & D3DLOCK_READONLY) == 0) {
       {
         Commands::Flags cmdFlags = 0;
+        const void* pCompressed = nullptr;
+        size_t compressedSize = 0;
 
         if (m_bUseSharedHeap) {
           cmdFlags = Commands::FlagBits::DataInSharedHeap;
@@ -203,6 +206,8 @@ protected:
                         "Application will now exit.");
             throw;
           }
+        } else if (UploadCompressor::compress(ptr, size, pCompressed, compressedSize)) {
+          cmdFlags = Commands::FlagBits::DataIsCompressed;
         }
 
         // Send the buffer lock parameters and handle
@@ -216,6 +221,8 @@ protected:
           const uint32_t dataOffset = static_cast<uint32_t*>(ptr) -
             DeviceBridge::getWriterChannel().get_data_ptr();
           c.send_many(dataOffset);
+        } else if (pCompressed) {
+          c.send_data(compressedSize, pCompressed);
         } else {
           // Now send the buffer bytes
           c.send_data(size, ptr);
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "client_options.h"
+#include "draw_batch.h"
+#include "upload_compressor.h"
+#include "util_devicecommand.h"
+
+#include <mutex>
+#include <vector>
+
+// Holds back the data of unlocked texture levels and cube map faces, so that
+// filling a whole mip chain, or all faces of a cube map, ships to the server
+// as a single command with a single blob that it uploads in one pass,
+// instead of one command per surface.
+//
+// The rows are copied out when a surface is unlocked, so held uploads do not
+// depend on the surface staying alive or unlocked. They are flushed before
+// any other command is started, through the device bridge's held commands
+// callback, which covers the SetTexture binding the texture and the Present
+// ending the frame. A run also ends when another texture is uploaded or when
+// the held data would grow past the configured maximum.
+class UploadBatch {
+public:
+  static bool isEnabled() {
+    static const bool bEnabled = ClientOptions::getCoalesceTextureUploads();
+    return bEnabled;
+  }
+
+  // Starts holding an upload of the given surface rect and returns where to
+  // copy its tightly packed rows to, or nullptr if the upload is too large
+  // to be held and has to be sent on its own. A non-null return must be
+  // followed by end().
+  static uint8_t* begin(const uintptr_t textureHandle, const uintptr_t surfaceHandle,
+                        const RECT& rect, const DWORD flags, const D3DFORMAT format,
+                        const uint32_t rowSize, const size_t size) {
+    static const size_t maxSize = (size_t) ClientOptions::getCoalesceTextureUploadsMaxKB() << 10;
+    if (size > maxSize) {
+      return nullptr;
+    }
+    // Held draws were issued before this upload and have to go first, which
+    // keeps held uploads always older than held draws
+    DrawBatch::flush();
+    s_mutex.lock();
+    if (!s_rects.empty() &&
+        (textureHandle != s_textureHandle || s_data.size() + size > maxSize)) {
+      flush();
+    }
+    s_textureHandle = textureHandle;
+    s_rects.insert(s_rects.end(), {
+      (uint32_t) surfaceHandle,
+      (uint32_t) rect.left, (uint32_t) rect.top, (uint32_t) rect.right, (uint32_t) rect.bottom,
+      (uint32_t) flags, (uint32_t) format, rowSize
+    });
+    const size_t offset = s_data.size();
+    s_data.resize(offset + size);
+    return s_data.data() + offset;
+  }
+
+  static void end() {
+    s_mutex.unlock();
+  }
+
+  // Sends the held uploads, if any
+  static void flush() {
+    std::scoped_lock lock(s_mutex);
+    // Sending the uploads starts a command which calls back into here
+    if (s_rects.empty() || s_bFlushing) {
+      return;
+    }
+    s_bFlushing = true;
+    Commands::Flags dataFlag = 0;
+    const void* pData = s_data.data();
+    size_t dataSize = s_data.size();
+    // The flush may run from the constructor of a command whose payload
+    // already sits in the thread's compression scratch, so use a buffer of
+    // our own
+    if (UploadCompressor::isEnabled() &&
+        UploadCompressor::compress(s_data.data(), s_data.size(), s_compressed, pData, dataSize)) {
+      dataFlag = Commands::FlagBits::DataIsCompressed;
+    }
+    {
+      ClientMessage c(Commands::IDirect3DSurface9_UnlockRects, s_textureHandle, dataFlag);
+      c.send_vectored((uint32_t) (s_rects.size() / Commands::kUnlockRectsWordsPerRect),
+                      DataBlob { s_rects.size() * sizeof(uint32_t), s_rects.data() },
+                      DataBlob { dataSize, pData });
+    }
+    s_rects.clear();
+    s_data.clear();
+    s_bFlushing = false;
+  }
+
+  // Whether the calling thread is sending held uploads. The held draws must
+  // not be flushed in between since they are newer.
+  static bool isFlushing() {
+    return s_bFlushing;
+  }
+
+private:
+  static inline std::recursive_mutex s_mutex;
+  static inline std::vector<uint32_t> s_rects;
+  static inline std::vector<uint8_t> s_data;
+  static inline std::vector<uint8_t> s_compressed;
+  static inline uintptr_t s_textureHandle = 0;
+  static inline thread_local bool s_bFlushing = false;
+};
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "client_options.h"
+#include "util_compression.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// Optional compression of large upload payloads (buffer and surface data)
+// sent through the data queue, for when queue bandwidth is the bottleneck.
+//
+// Compression is adaptive: each attempt is timed and its ratio measured, and
+// if it does not pay off (too little saved, or compressing slower than the
+// configured floor) further attempts are skipped for an exponentially
+// growing number of uploads before probing again.
+class UploadCompressor {
+public:
+  static bool isEnabled() {
+    static const bool bEnabled = ClientOptions::getCompressUploads();
+    return bEnabled;
+  }
+
+  // Thread local scratch for gathering non-contiguous data (e.g. the rows of
+  // a surface rect) before compressing it.
+  static uint8_t* getGatherBuffer(const size_t size) {
+    auto& buffer = getScratch().gather;
+    if (buffer.size() < size) {
+      buffer.resize(size);
+    }
+    return buffer.data();
+  }
+
+  // Returns true and points pCompressed at the compressed payload if the
+  // data should be sent compressed. The payload stays valid until the next
+  // call on the same thread.
+  //
+  // Starting a command may flush held commands, which compress too. Those
+  // must pass a buffer of their own, so that a payload compressed ahead of
+  // its command is not overwritten by the flush.
+  static bool compress(const void* pData, const size_t size,
+                       const void*& pCompressed, size_t& compressedSize) {
+    return compress(pData, size, getScratch().compressed, pCompressed, compressedSize);
+  }
+
+  // Same as above, with the payload going to the given buffer, where it stays
+  // valid until the buffer is modified
+  static bool compress(const void* pData, const size_t size, std::vector<uint8_t>& buffer,
+                       const void*& pCompressed, size_t& compressedSize) {
+    static const uint32_t threshold = ClientOptions::getCompressUploadsThreshold();
+    if (!isEnabled() || size < threshold || !shouldAttempt()) {
+      return false;
+    }
+
+    const size_t bound = bridge_util::Compression::compressBound(size);
+    if (buffer.size() < bound) {
+      buffer.resize(bound);
+    }
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    // Capping the output at the profitable size lets incompressible data
+    // bail out early instead of being compressed in full
+    const size_t maxCompressedSize = (size_t) (size * getMaxRatio());
+    compressedSize = bridge_util::Compression::compress(pData, size, buffer.data(), maxCompressedSize);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const double mbPerSecond = seconds > 0.0 ? (double) size / (seconds * 1024.0 * 1024.0) : 0.0;
+    const bool bProfitable = compressedSize != 0 &&
+      (seconds <= 0.0 || mbPerSecond >= ClientOptions::getCompressUploadsMinSpeedMBps());
+    onAttempt(bProfitable);
+
+    if (compressedSize == 0) {
+      return false;
+    }
+    // Even if too slow this time the work is done, so send the smaller payload
+    pCompressed = buffer.data();
+    return true;
+  }
+
+private:
+  struct Scratch {
+    std::vector<uint8_t> gather;
+    std::vector<uint8_t> compressed;
+  };
+
+  static constexpr uint32_t kMaxBackoff = 256;
+
+  static Scratch& getScratch() {
+    thread_local Scratch scratch;
+    return scratch;
+  }
+
+  static float getMaxRatio() {
+    static const float maxRatio = ClientOptions::getCompressUploadsMaxRatio();
+    return maxRatio;
+  }
+
+  static bool shouldAttempt() {
+    std::scoped_lock lock(s_mutex);
+    if (s_skipCount > 0) {
+      --s_skipCount;
+      return false;
+    }
+    return true;
+  }
+
+  static void onAttempt(const bool bProfitable) {
+    std::scoped_lock lock(s_mutex);
+    if (bProfitable) {
+      s_backoff = 0;
+    } else {
+      s_backoff = s_backoff == 0 ? 1 : std::min(s_backoff * 2, kMaxBackoff);
+      s_skipCount = s_backoff;
+    }
+  }
+
+  inline static std::mutex s_mutex;
+  inline static uint32_t s_backoff = 0;
+  inline static uint32_t s_skipCount = 0;
+};
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <cassert>
+#include <functional>
+#include <map>
+#include <unordered_map>
+
+// Handle to x64 object map that lazily resolves the children of container
+// objects (texture surfaces and volumes).
+//
+// The client reserves a contiguous block of handles for all children of a
+// container when the container is created, with the child handle being the
+// first handle of the block plus the child index. The server registers that
+// block along with a resolver, and the real child object is only looked up
+// when one of its handles is first accessed, so no registration command has
+// to be sent for it.
+template<typename T>
+class LazyChildMap {
+  using Map = std::unordered_map<uint32_t, T*>;
+
+public:
+  using Resolver = std::function<T*(uint32_t childIndex)>;
+
+  T*& operator[](const uint32_t handle) {
+    auto it = m_map.find(handle);
+    if (it != m_map.end()) {
+      return it->second;
+    }
+    return m_map[handle] = resolveChild(handle);
+  }
+
+  // Note: erasing a handle does not resolve it, so children that were never
+  // accessed can be unlinked without ever touching the x64 object.
+  size_t erase(const uint32_t handle) {
+    return m_map.erase(handle);
+  }
+
+  void registerChildren(const uint32_t parentHandle, const uint32_t firstChildHandle,
+                        const uint32_t numChildren, Resolver resolver) {
+    if (numChildren == 0) {
+      return;
+    }
+    assert(m_parents.count(parentHandle) == 0 && "Children already registered for parent!");
+    m_ranges[firstChildHandle] = { numChildren, std::move(resolver) };
+    m_parents[parentHandle] = firstChildHandle;
+  }
+
+  // Drops the child handle block of a parent along with any children
+  // resolved from it.
+  void unregisterChildren(const uint32_t parentHandle) {
+    auto parentIt = m_parents.find(parentHandle);
+    if (parentIt == m_parents.end()) {
+      return;
+    }
+    const uint32_t firstChildHandle = parentIt->second;
+    auto rangeIt = m_ranges.find(firstChildHandle);
+    assert(rangeIt != m_ranges.end());
+    for (uint32_t i = 0; i < rangeIt->second.numChildren; ++i) {
+      m_map.erase(firstChildHandle + i);
+    }
+    m_ranges.erase(rangeIt);
+    m_parents.erase(parentIt);
+  }
+
+  bool empty() const {
+    return m_map.empty();
+  }
+
+  size_t size() const {
+    return m_map.size();
+  }
+
+  typename Map::const_iterator begin() const {
+    return m_map.begin();
+  }
+
+  typename Map::const_iterator end() const {
+    return m_map.end();
+  }
+
+private:
+  struct ChildRange {
+    uint32_t numChildren;
+    Resolver resolver;
+  };
+
+  T* resolveChild(const uint32_t handle) {
+    auto it = m_ranges.upper_bound(handle);
+    if (it == m_ranges.begin()) {
+      return nullptr;
+    }
+    --it;
+    const uint32_t childIndex = handle - it->first;
+    if (childIndex >= it->second.numChildren) {
+      return nullptr;
+    }
+    return it->second.resolver(childIndex);
+  }
+
+  Map m_map;
+  // Child handle blocks keyed by their first handle
+  std::map<uint32_t, ChildRange> m_ranges;
+  std::unordered_map<uint32_t, uint32_t> m_parents;
+};
@@ -22,19 +22,25 @@
 #include <windows.h>
 
 #include "version.h"
+#include "lazy_child_map.h"
 #include "module_processing.h"
 #include "remix_api.h"
 
 #include "util_bridge_assert.h"
 #include "util_circularbuffer.h"
+#include "util_commandhistory.h"
 #include "util_commands.h"
+#include "util_compression.h"
 #include "util_common.h"
 #include "util_devicecommand.h"
+#include "util_devicestatus.h"
 #include "util_filesys.h"
+#include "util_frametimeline.h"
 #include "util_guid.h"
 #include "util_hack_d3d_debug.h"
 #include "util_messagechannel.h"
 #include "util_modulecommand.h"
+#include "util_phasetimer.h"
 #include "util_process.h"
 #include "util_remixapi.h"
 #include "util_seh.h"
@@ -42,12 +48,15 @@
 #include "util_sharedheap.h"
 #include "util_sharedmemory.h"
 #include "util_texture_and_volume.h"
+#include "util_validation.h"
 #include "util_version.h"
 
 #include "log/log.h"
 #include "config/config.h"
 #include "config/global_options.h"
 #include "server_options.h"
+#include "staging_pool.h"
+#include "thread_placement.h"
 #include "../client/client_options.h"
 
 #include "../tracy/tracy.hpp"
@@ -57,6 +66,7 @@
 #include <map>
 #include <atomic>
 #include <array>
+#include <future>
 
 using namespace Commands;
 using namespace bridge_util;
@@ -86,23 +96,23 @@ using namespace remixapi::util;
 #define PULL_H(name) PULL(HRESULT, name)
 #define PULL_HND(name) \
             PULL_U(name); \
-            assert(name != NULL)
+            BRIDGE_VALIDATE_CHEAP(name != NULL)
 #define PULL_DATA(size, name) \
             uint32_t name##_len = DeviceBridge::get_data((void**)&name); \
-            assert(name##_len == 0 || size == name##_len)
+            BRIDGE_VALIDATE_CHEAP(name##_len == 0 || size == name##_len)
 #define PULL_OBJ(type, name) \
             type* name = nullptr; \
             PULL_DATA(sizeof(type), name)
 #define CHECK_DATA_OFFSET (DeviceBridge::get_data_pos() == rpcHeader.dataOffset)
 #define GET_HND(name) \
             const auto& name = rpcHeader.pHandle; \
-            assert(name != NULL)
+            BRIDGE_VALIDATE_CHEAP(name != NULL)
 #define GET_HDR_VAL(name) \
             const DWORD& name = rpcHeader.pHandle;
 #define GET_RES(name, map) \
             GET_HND(name##Handle); \
             const auto& name = map[name##Handle]; \
-            assert(name != NULL)
+            BRIDGE_VALIDATE_CHEAP(name != NULL)
 
 // NOTE: MSDN states HWNDs are safe to cross x86-->x64 boundary, and that a truncating cast should be used:
 // https://docs.microsoft.com/en-us/windows/win32/winprog64/interprocess-communication?redirectedfrom=MSDN
@@ -125,8 +135,8 @@ bool gOverwriteConditionAlreadyActive = false;
 
 // Mapping between client and server pointer addresses
 std::unordered_map<uint32_t, IDirect3DDevice9*> gpD3DDevices;
-std::unordered_map<uint32_t, IDirect3DResource9*> gpD3DResources; // For Textures, Buffers, and Surfaces
-std::unordered_map<uint32_t, IDirect3DVolume9*> gpD3DVolumes;
+LazyChildMap<IDirect3DResource9> gpD3DResources; // For Textures, Buffers, and Surfaces
+LazyChildMap<IDirect3DVolume9> gpD3DVolumes;
 std::unordered_map<uint32_t, IDirect3DVertexDeclaration9*> gpD3DVertexDeclarations;
 std::unordered_map<uint32_t, IDirect3DStateBlock9*> gpD3DStateBlocks;
 std::unordered_map<uint32_t, IDirect3DVertexShader9*> gpD3DVertexShaders;
@@ -141,10 +151,13 @@ HANDLE hWait;
 
 namespace {
 template<typename SerializableT>
-static void deserializeFromQueue(SerializableT& serializableT) {
+static void deserializeFromQueue(SerializableT& serializableT, remixapi::DedupKey* pContentKey = nullptr) {
   static_assert(is_serializable_v<SerializableT>, "deserializeRemixApiT(...)  may only be called with defined Serializable<T> types");
   void* pSlzdData = nullptr;
   const auto size = DeviceBridge::get_data(&pSlzdData);
+  if (pContentKey) {
+    pContentKey->append(pSlzdData, size);
+  }
   SerializableT dslz(pSlzdData);
   assert(size == dslz.size());
   dslz.deserialize();
@@ -170,6 +183,89 @@ static inline void safeDestroy(IUnknown* obj, uint32_t x86handle) {
   while (obj && static_cast<LONG>(obj->Release()) > 0);
 }
 
+static inline void publishDisplayMode(IDirect3DDevice9* pD3DDevice, const uint32_t deviceHandle) {
+  D3DDISPLAYMODEEX mode = { sizeof(D3DDISPLAYMODEEX) };
+  D3DDISPLAYROTATION rotation = D3DDISPLAYROTATION_IDENTITY;
+  IDirect3DDevice9Ex* pD3DDeviceEx = nullptr;
+  if (SUCCEEDED(pD3DDevice->QueryInterface(__uuidof(IDirect3DDevice9Ex), (void**) &pD3DDeviceEx))) {
+    const auto hresult = pD3DDeviceEx->GetDisplayModeEx(0, &mode, &rotation);
+    pD3DDeviceEx->Release();
+    if (FAILED(hresult)) {
+      return;
+    }
+  } else {
+    D3DDISPLAYMODE baseMode;
+    if (FAILED(pD3DDevice->GetDisplayMode(0, &baseMode))) {
+      return;
+    }
+    mode.Width = baseMode.Width;
+    mode.Height = baseMode.Height;
+    mode.RefreshRate = baseMode.RefreshRate;
+    mode.Format = baseMode.Format;
+    mode.ScanLineOrdering = D3DSCANLINEORDERING_PROGRESSIVE;
+  }
+  DeviceStatus::publishDisplayMode(deviceHandle, { mode.Width, mode.Height, mode.RefreshRate,
+                                                   (uint32_t) mode.Format, (uint32_t) mode.ScanLineOrdering,
+                                                   (uint32_t) rotation });
+}
+
+// Devices other than the one pacing the global Present semaphore have a
+// semaphore of their own, so that their Presents don't throttle each other.
+std::unordered_map<IDirect3DDevice9*, NamedSemaphore*> gPresentSemaphores;
+
+static void createPresentSemaphore(IDirect3DDevice9* pD3DDevice, const uint32_t deviceHandle) {
+  const auto maxFrames = GlobalOptions::getPresentSemaphoreMaxFrames();
+  gPresentSemaphores[pD3DDevice] = new NamedSemaphore(format_string("Present%u", deviceHandle), maxFrames, maxFrames);
+}
+
+static void releasePresentSemaphore(IDirect3DDevice9* pD3DDevice) {
+  const auto it = gPresentSemaphores.find(pD3DDevice);
+  (it != gPresentSemaphores.end() ? it->second : gpPresent)->release();
+}
+
+static void destroyPresentSemaphore(IDirect3DDevice9* pD3DDevice) {
+  const auto it = gPresentSemaphores.find(pD3DDevice);
+  if (it != gPresentSemaphores.end()) {
+    delete it->second;
+    gPresentSemaphores.erase(it);
+  }
+}
+
+// Publishes the server's data queue position to the client. The client keeps a
+// conservative view of it and only looks at it when space runs low, so the
+// shared value is updated in batches rather than after every command: when the
+// position wraps, after a sizable chunk of the queue has been consumed, when
+// the client is waiting on an overwrite condition, or when the server is about
+// to go idle.
+static inline void publishServerDataPos() {
+  auto& channel = DeviceBridge::getReaderChannel();
+  static const int64_t kPublishInterval = std::max<int64_t>(1, (int64_t) channel.data->get_total_size() / 32);
+  static int64_t lastPublishedPos = -1;
+  const int64_t pos = (int64_t) DeviceBridge::get_data_pos();
+  if (pos < lastPublishedPos ||
+      pos - lastPublishedPos >= kPublishInterval ||
+      *channel.clientDataExpectedPos != -1 ||
+      channel.commands->isEmpty()) {
+    *channel.serverDataPos = pos;
+    lastPublishedPos = pos;
+  }
+}
+
+static inline void publishDeviceStatus(IDirect3DDevice9* pD3DDevice, const uint32_t deviceHandle) {
+  if (DeviceStatus::isInitialized()) {
+    DeviceStatus::publishAvailableTextureMem(deviceHandle, pD3DDevice->GetAvailableTextureMem());
+    // Mode switches and windows moving between monitors are picked up here
+    publishDisplayMode(pD3DDevice, deviceHandle);
+    // Device loss and occlusion of the device window, so that the client can
+    // answer CheckDeviceState() without a round trip
+    IDirect3DDevice9Ex* pD3DDeviceEx = nullptr;
+    if (SUCCEEDED(pD3DDevice->QueryInterface(__uuidof(IDirect3DDevice9Ex), (void**) &pD3DDeviceEx))) {
+      DeviceStatus::publishDeviceState(deviceHandle, (uint32_t) pD3DDeviceEx->CheckDeviceState(nullptr));
+      pD3DDeviceEx->Release();
+    }
+  }
+}
+
 D3DPRESENT_PARAMETERS getPresParamFromRaw(const uint32_t* rawPresentationParameters) {
   D3DPRESENT_PARAMETERS presParam;
   // Set up presentation parameters. We can't just directly cast the structure because the hDeviceWindow
@@ -195,6 +291,92 @@ D3DPRESENT_PARAMETERS getPresParamFromRaw(const uint32_t* rawPresentationParamet
   return presParam;
 }
 
+// Applies the input assembly bindings encoded by the client device's
+// encodeInputAssembly() and returns the first word past them. Any failure
+// is reported through hresult, which is left untouched otherwise.
+static const uint32_t* applyInputAssembly(IDirect3DDevice9* pD3DDevice, const uint32_t* pWords, HRESULT& hresult) {
+  const uint32_t streamMask = *pWords++;
+  const uint32_t streamFreqMask = *pWords++;
+  const uint32_t flags = *pWords++;
+  for (uint32_t i = 0; i < caps::MaxStreams; ++i) {
+    if (streamMask & (1 << i)) {
+      const uint32_t pHandle = *pWords++;
+      const uint32_t OffsetInBytes = *pWords++;
+      const uint32_t Stride = *pWords++;
+      IDirect3DVertexBuffer9* pStreamData = nullptr;
+      if (pHandle != NULL) {
+        pStreamData = (IDirect3DVertexBuffer9*) gpD3DResources[pHandle];
+      }
+      const auto hr = pD3DDevice->SetStreamSource(IN i, IN pStreamData, IN OffsetInBytes, IN Stride);
+      assert(SUCCEEDED(hr));
+      hresult = FAILED(hr) ? hr : hresult;
+    }
+  }
+  for (uint32_t i = 0; i < caps::MaxStreams; ++i) {
+    if (streamFreqMask & (1 << i)) {
+      const auto hr = pD3DDevice->SetStreamSourceFreq(IN i, IN *pWords++);
+      assert(SUCCEEDED(hr));
+      hresult = FAILED(hr) ? hr : hresult;
+    }
+  }
+  if (flags & Commands::IndicesChanged) {
+    const uint32_t pHandle = *pWords++;
+    IDirect3DIndexBuffer9* pIndexData = NULL;
+    if (pHandle != NULL) {
+      pIndexData = (IDirect3DIndexBuffer9*) gpD3DResources[pHandle];
+    }
+    const auto hr = pD3DDevice->SetIndices(IN pIndexData);
+    assert(SUCCEEDED(hr));
+    hresult = FAILED(hr) ? hr : hresult;
+  }
+  if (flags & Commands::VertexDeclChanged) {
+    const uint32_t pHandle = *pWords++;
+    IDirect3DVertexDeclaration9* pVertexDecl = nullptr;
+    if (pHandle != NULL) {
+      pVertexDecl = (IDirect3DVertexDeclaration9*) gpD3DVertexDeclarations[pHandle];
+    }
+    const auto hr = pD3DDevice->SetVertexDeclaration(IN pVertexDecl);
+    assert(SUCCEEDED(hr));
+    hresult = FAILED(hr) ? hr : hresult;
+  } else if (flags & Commands::FVFChanged) {
+    const auto hr = pD3DDevice->SetFVF(IN (DWORD) *pWords++);
+    assert(SUCCEEDED(hr));
+    hresult = FAILED(hr) ? hr : hresult;
+  }
+  return pWords;
+}
+
+// Applies the transforms and lights encoded by the client device's
+// encodeTransformsAndLights() and returns the first word past them. Any
+// failure is reported through hresult, which is left untouched otherwise.
+static const uint32_t* applyTransformsAndLights(IDirect3DDevice9* pD3DDevice, const uint32_t* pWords, HRESULT& hresult) {
+  const uint32_t numTransforms = *pWords++;
+  const uint32_t numLights = *pWords++;
+  const uint32_t numLightEnables = *pWords++;
+  for (uint32_t i = 0; i < numTransforms; ++i) {
+    const auto State = (D3DTRANSFORMSTATETYPE) *pWords++;
+    const auto hr = pD3DDevice->SetTransform(IN State, IN (const D3DMATRIX*) pWords);
+    assert(SUCCEEDED(hr));
+    hresult = FAILED(hr) ? hr : hresult;
+    pWords += sizeof(D3DMATRIX) / sizeof(uint32_t);
+  }
+  for (uint32_t i = 0; i < numLights; ++i) {
+    const DWORD Index = *pWords++;
+    const auto hr = pD3DDevice->SetLight(IN Index, IN (const D3DLIGHT9*) pWords);
+    assert(SUCCEEDED(hr));
+    hresult = FAILED(hr) ? hr : hresult;
+    pWords += sizeof(D3DLIGHT9) / sizeof(uint32_t);
+  }
+  for (uint32_t i = 0; i < numLightEnables; ++i) {
+    const DWORD LightIndex = *pWords++;
+    const BOOL bEnable = (BOOL) *pWords++;
+    const auto hr = pD3DDevice->LightEnable(IN LightIndex, IN bEnable);
+    assert(SUCCEEDED(hr));
+    hresult = FAILED(hr) ? hr : hresult;
+  }
+  return pWords;
+}
+
 HRESULT ReturnSurfaceDataToClient(IDirect3DSurface9* pReturnSurfaceData, HRESULT hresult, UINT currentUID) {
   // We send the HRESULT response back to the client even in case of failure
   ServerMessage c(Commands::Bridge_Response, currentUID);
@@ -282,6 +464,13 @@ void ProcessDeviceCommandQueue() {
 #endif
 
     const Header rpcHeader = DeviceBridge::pop_front();
+    FrameTimeline::onServerCommand();
+
+    // Get the data of the commands queued behind this one on its way into
+    // the cache while this one executes
+    if (const uint32_t lookahead = ServerOptions::getCommandLookahead()) {
+      DeviceBridge::prefetch_ahead(rpcHeader, lookahead);
+    }
 
 #ifdef _DEBUG
     // If data batching is enabled and the data offset on the comamnd is different from
@@ -300,11 +489,20 @@ void ProcessDeviceCommandQueue() {
         ZoneName(commandStr.c_str(), commandStr.size());
       }
       PULL_U(currentUID);
+      CommandHistory::record('D', CommandHistory::Direction::Received, rpcHeader.command, currentUID,
+                             DeviceBridge::get_pending_data_size(rpcHeader.dataOffset));
 #if defined(_DEBUG) || defined(DEBUGOPT)
       if (GlobalOptions::getLogServerCommands()) {
         Logger::info("Device Processing: " + toString(rpcHeader.command) + " UID: " + std::to_string(currentUID));
       }
 #endif
+      // Surface uploads queued up in the staging pool must land before any
+      // other command gets to see the surfaces
+      if (StagingPool::hasPending() &&
+          rpcHeader.command != IDirect3DSurface9_UnlockRect &&
+          rpcHeader.command != IDirect3DSurface9_UnlockRects) {
+        StagingPool::flush();
+      }
       // The mother of all switch statements - every call in the D3D9 interface is mapped here...
       switch (rpcHeader.command) {
       case IDirect3D9Ex_CreateDeviceEx:
@@ -320,6 +518,7 @@ void ProcessDeviceCommandQueue() {
         uint32_t* rawPresentationParameters = nullptr;
         DeviceBridge::get_data((void**) &rawPresentationParameters);
         D3DPRESENT_PARAMETERS PresentationParameters = getPresParamFromRaw(rawPresentationParameters);
+        PULL_U(bOwnPresentSemaphore);
 
         IDirect3DDevice9Ex* pD3DDevice = nullptr;
         const auto hresult = ((IDirect3D9Ex*) gpD3D)->CreateDeviceEx(IN Adapter, IN DeviceType, IN TRUNCATE_HANDLE(HWND, hFocusWindow), IN BehaviorFlags, IN OUT & PresentationParameters, IN pFullscreenDisplayMode, OUT & pD3DDevice);
@@ -330,6 +529,10 @@ void ProcessDeviceCommandQueue() {
         } else {
           Logger::info("Server side D3D9 DeviceEx created successfully!");
           gpD3DDevices[pHandle] = pD3DDevice;
+          publishDeviceStatus(pD3DDevice, pHandle);
+          if (bOwnPresentSemaphore) {
+            createPresentSemaphore(pD3DDevice, pHandle);
+          }
           if(GlobalOptions::getExposeRemixApi()) {
             remixapi::g_device = pD3DDevice;
             remixapi::g_remix.dxvk_RegisterD3D9Device(remixapi::g_device);
@@ -355,6 +558,7 @@ void ProcessDeviceCommandQueue() {
         uint32_t* rawPresentationParameters = nullptr;
         DeviceBridge::get_data((void**) &rawPresentationParameters);
         D3DPRESENT_PARAMETERS PresentationParameters = getPresParamFromRaw(rawPresentationParameters);
+        PULL_U(bOwnPresentSemaphore);
 
         IDirect3DDevice9* pD3DDevice = nullptr;
         const auto hresult = gpD3D->CreateDevice(IN Adapter, IN DeviceType, IN TRUNCATE_HANDLE(HWND, hFocusWindow), IN BehaviorFlags, IN OUT & PresentationParameters, OUT & pD3DDevice);
@@ -365,6 +569,10 @@ void ProcessDeviceCommandQueue() {
         } else {
           Logger::info("Server side D3D9 Device created successfully!");
           gpD3DDevices[pHandle] = (IDirect3DDevice9Ex*) pD3DDevice;
+          publishDeviceStatus(pD3DDevice, pHandle);
+          if (bOwnPresentSemaphore) {
+            createPresentSemaphore(pD3DDevice, pHandle);
+          }
           if(GlobalOptions::getExposeRemixApi()) {
             remixapi::g_device = (IDirect3DDevice9Ex*) pD3DDevice;
             remixapi::g_remix.dxvk_RegisterD3D9Device(remixapi::g_device);
@@ -501,6 +709,11 @@ void ProcessDeviceCommandQueue() {
       case IDirect3DDevice9Ex_Destroy:
       {
         GET_RES(pD3DDevice, gpD3DDevices);
+        destroyPresentSemaphore(pD3DDevice);
+        StagingPool::releaseDevice(pD3DDevice);
+        if (DeviceStatus::isInitialized()) {
+          DeviceStatus::releaseDevice(pD3DDeviceHandle);
+        }
         safeDestroy(pD3DDevice, pD3DDeviceHandle);
         gpD3DDevices.erase(pD3DDeviceHandle);
         break;
@@ -516,6 +729,9 @@ void ProcessDeviceCommandQueue() {
       {
         GET_RES(pD3DDevice, gpD3DDevices);
         const auto mem = pD3DDevice->GetAvailableTextureMem();
+        if (DeviceStatus::isInitialized()) {
+          DeviceStatus::publishAvailableTextureMem(pD3DDeviceHandle, mem);
+        }
         {
           ServerMessage c(Commands::Bridge_Response, currentUID);
           c.send_data(mem);
@@ -527,6 +743,10 @@ void ProcessDeviceCommandQueue() {
         GET_RES(pD3DDevice, gpD3DDevices);
         auto const hresult = pD3DDevice->EvictManagedResources();
         assert(SUCCEEDED(hresult));
+        publishDeviceStatus(pD3DDevice, pD3DDeviceHandle);
+        if (DeviceStatus::isInitialized()) {
+          DeviceStatus::onInvalidated();
+        }
         SEND_OPTIONAL_SERVER_RESPONSE(hresult, currentUID);
         break;
       }
@@ -600,11 +820,10 @@ void ProcessDeviceCommandQueue() {
       {
         GET_RES(pD3DDevice, gpD3DDevices);
         PULL(BOOL, bShow);
+        // The client tracks the cursor visibility itself, so the previous
+        // state is only sent back when every command is acknowledged
         const BOOL prevShow = pD3DDevice->ShowCursor(bShow);
-        {
-          ServerMessage c(Commands::Bridge_Response, currentUID);
-          c.send_data(prevShow);
-        }
+        SEND_OPTIONAL_SERVER_RESPONSE(prevShow, currentUID);
         break;
       }
       case IDirect3DDevice9Ex_CreateAdditionalSwapChain:
@@ -660,12 +879,17 @@ void ProcessDeviceCommandQueue() {
 
         const auto hresult = pD3DDevice->Reset(&PresentationParameters);
         assert(SUCCEEDED(hresult));
+        publishDeviceStatus(pD3DDevice, pD3DDeviceHandle);
+        if (DeviceStatus::isInitialized()) {
+          DeviceStatus::onInvalidated();
+        }
         SEND_OPTIONAL_SERVER_RESPONSE(hresult, currentUID);
         break;
       }
       case IDirect3DDevice9Ex_Present:
       {
         FrameMark;
+        FrameTimeline::onServerPresentPulled();
 #ifdef ENABLE_PRESENT_SEMAPHORE_TRACE
         Logger::trace("Server side Present call received, releasing semaphore...");
 #endif
@@ -679,15 +903,18 @@ void ProcessDeviceCommandQueue() {
         HWND hwnd = TRUNCATE_HANDLE(HWND, hDestWindowOverride);
 
         const auto hresult = pD3DDevice->Present(pSourceRect, pDestRect, hwnd, pDirtyRegion);
+        FrameTimeline::onServerPresentDone();
         if (!SUCCEEDED(hresult)) {
           std::stringstream ss;
           ss << "Present() failed! Check all logs for reported errors.";
           Logger::err(ss.str());
         }
 
+        publishDeviceStatus(pD3DDevice, pD3DDeviceHandle);
+
         // If we're syncing with the client on Present() then trigger the semaphore now
         if (GlobalOptions::getPresentSemaphoreEnabled()) {
-          gpPresent->release();
+          releasePresentSemaphore(pD3DDevice);
 #ifdef ENABLE_PRESENT_SEMAPHORE_TRACE
           Logger::trace("Present semaphore released successfully.");
 #endif
@@ -746,10 +973,19 @@ void ProcessDeviceCommandQueue() {
         PULL(D3DFORMAT, Format);
         PULL(D3DPOOL, Pool);
         PULL_HND(pHandle);
+        PULL_U(FirstChildHandle);
+        PULL_U(NumChildren);
         LPDIRECT3DTEXTURE9 pTexture;
         const auto hresult = pD3DDevice->CreateTexture(IN Width, IN Height, IN Levels, IN Usage, IN Format, IN Pool, OUT & pTexture, IN nullptr);
         if (SUCCEEDED(hresult)) {
           gpD3DResources[pHandle] = pTexture;
+          gpD3DResources.registerChildren(pHandle, FirstChildHandle, NumChildren,
+            [pTexture](uint32_t level) -> IDirect3DResource9* {
+              LPDIRECT3DSURFACE9 pSurfaceLevel = nullptr;
+              const auto hresult = pTexture->GetSurfaceLevel(IN level, OUT & pSurfaceLevel);
+              assert(SUCCEEDED(hresult));
+              return pSurfaceLevel;
+            });
         }
         assert(SUCCEEDED(hresult));
         SEND_OPTIONAL_CREATE_FUNCTION_SERVER_RESPONSE(hresult, currentUID);
@@ -766,10 +1002,19 @@ void ProcessDeviceCommandQueue() {
         PULL(D3DFORMAT, Format);
         PULL(D3DPOOL, Pool);
         PULL_HND(pHandle);
+        PULL_U(FirstChildHandle);
+        PULL_U(NumChildren);
         LPDIRECT3DVOLUMETEXTURE9 pVolumeTexture;
         const auto hresult = pD3DDevice->CreateVolumeTexture(IN Width, IN Height, IN Depth, IN Levels, IN Usage, IN Format, IN Pool, OUT & pVolumeTexture, IN nullptr);
         if (SUCCEEDED(hresult)) {
           gpD3DResources[pHandle] = pVolumeTexture;
+          gpD3DVolumes.registerChildren(pHandle, FirstChildHandle, NumChildren,
+            [pVolumeTexture](uint32_t level) -> IDirect3DVolume9* {
+              LPDIRECT3DVOLUME9 pVolumeLevel = nullptr;
+              const auto hresult = pVolumeTexture->GetVolumeLevel(IN level, OUT & pVolumeLevel);
+              assert(SUCCEEDED(hresult));
+              return pVolumeLevel;
+            });
         }
         assert(SUCCEEDED(hresult));
         SEND_OPTIONAL_CREATE_FUNCTION_SERVER_RESPONSE(hresult, currentUID);
@@ -784,10 +1029,22 @@ void ProcessDeviceCommandQueue() {
         PULL(D3DFORMAT, Format);
         PULL(D3DPOOL, Pool);
         PULL_HND(pHandle);
+        PULL_U(FirstChildHandle);
+        PULL_U(NumChildren);
         LPDIRECT3DCUBETEXTURE9 pCubeTexture;
         const auto hresult = pD3DDevice->CreateCubeTexture(IN EdgeLength, IN Levels, IN Usage, IN Format, IN Pool, OUT & pCubeTexture, IN nullptr);
         if (SUCCEEDED(hresult)) {
           gpD3DResources[pHandle] = pCubeTexture;
+          // Cube child index is laid out as face + level * 6, matching the client
+          gpD3DResources.registerChildren(pHandle, FirstChildHandle, NumChildren,
+            [pCubeTexture](uint32_t index) -> IDirect3DResource9* {
+              const auto face = (D3DCUBEMAP_FACES) (index % 6);
+              const UINT level = index / 6;
+              LPDIRECT3DSURFACE9 pCubeMapSurface = nullptr;
+              const auto hresult = pCubeTexture->GetCubeMapSurface(IN face, IN level, OUT & pCubeMapSurface);
+              assert(SUCCEEDED(hresult));
+              return pCubeMapSurface;
+            });
         }
         assert(SUCCEEDED(hresult));
         SEND_OPTIONAL_CREATE_FUNCTION_SERVER_RESPONSE(hresult, currentUID);
@@ -1260,10 +1517,7 @@ void ProcessDeviceCommandQueue() {
         PULL(BOOL, bSoftware);
         const auto hresult = pD3DDevice->SetSoftwareVertexProcessing(bSoftware);
         assert(SUCCEEDED(hresult));
-        {
-          ServerMessage c(Commands::Bridge_Response, currentUID);
-          c.send_data(hresult);
-        }
+        SEND_OPTIONAL_SERVER_RESPONSE(hresult, currentUID);
         break;
       }
       case IDirect3DDevice9Ex_GetSoftwareVertexProcessing:
@@ -1310,7 +1564,13 @@ void ProcessDeviceCommandQueue() {
         PULL(D3DPRIMITIVETYPE, PrimitiveType);
         PULL_U(PrimitiveCount);
         void* pVertexStreamZeroData = nullptr;
-        DeviceBridge::get_data(&pVertexStreamZeroData);
+        if (Commands::IsDataInSharedHeap(rpcHeader.flags)) {
+          PULL_U(allocId);
+          PULL_U(vertexOffset);
+          pVertexStreamZeroData = SharedHeap::getBuf(allocId) + vertexOffset;
+        } else {
+          DeviceBridge::get_data(&pVertexStreamZeroData);
+        }
         PULL_U(VertexStreamZeroStride);
         const auto hresult = pD3DDevice->DrawPrimitiveUP(IN PrimitiveType, IN PrimitiveCount, IN pVertexStreamZeroData, IN VertexStreamZeroStride);
         assert(SUCCEEDED(hresult));
@@ -1328,9 +1588,17 @@ void ProcessDeviceCommandQueue() {
         PULL_U(VertexStreamZeroStride);
 
         void* pIndexData = nullptr;
-        DeviceBridge::get_data(&pIndexData);
         void* pVertexStreamZeroData = nullptr;
-        DeviceBridge::get_data(&pVertexStreamZeroData);
+        if (Commands::IsDataInSharedHeap(rpcHeader.flags)) {
+          PULL_U(allocId);
+          PULL_U(indexOffset);
+          PULL_U(vertexOffset);
+          pIndexData = SharedHeap::getBuf(allocId) + indexOffset;
+          pVertexStreamZeroData = SharedHeap::getBuf(allocId) + vertexOffset;
+        } else {
+          DeviceBridge::get_data(&pIndexData);
+          DeviceBridge::get_data(&pVertexStreamZeroData);
+        }
 
         const auto hresult = pD3DDevice->DrawIndexedPrimitiveUP(IN PrimitiveType, IN MinVertexIndex, IN NumVertices, IN PrimitiveCount, IN pIndexData, IN IndexDataFormat, IN pVertexStreamZeroData, IN VertexStreamZeroStride);
         assert(SUCCEEDED(hresult));
@@ -1515,6 +1783,60 @@ void ProcessDeviceCommandQueue() {
       }
       case IDirect3DDevice9Ex_GetIndices:
         break;
+      case IDirect3DDevice9Ex_SetInputAssembly:
+      {
+        GET_RES(pD3DDevice, gpD3DDevices);
+        const uint32_t* pWords = nullptr;
+        const uint32_t size = DeviceBridge::get_data((void**) &pWords);
+        HRESULT hresult = S_OK;
+        const uint32_t* const pEnd = applyInputAssembly(pD3DDevice, pWords, hresult);
+        BRIDGE_VALIDATE_CHEAP((size_t) (pEnd - pWords) * sizeof(uint32_t) == size);
+        SEND_OPTIONAL_SERVER_RESPONSE(hresult, currentUID);
+        break;
+      }
+      case IDirect3DDevice9Ex_SetTransformsAndLights:
+      {
+        GET_RES(pD3DDevice, gpD3DDevices);
+        const uint32_t* pWords = nullptr;
+        const uint32_t size = DeviceBridge::get_data((void**) &pWords);
+        HRESULT hresult = S_OK;
+        const uint32_t* const pEnd = applyTransformsAndLights(pD3DDevice, pWords, hresult);
+        BRIDGE_VALIDATE_CHEAP((size_t) (pEnd - pWords) * sizeof(uint32_t) == size);
+        SEND_OPTIONAL_SERVER_RESPONSE(hresult, currentUID);
+        break;
+      }
+      case IDirect3DDevice9Ex_MultiDraw:
+      {
+        GET_RES(pD3DDevice, gpD3DDevices);
+        PULL_U(numDraws);
+        const uint32_t* pBegin = nullptr;
+        const uint32_t size = DeviceBridge::get_data((void**) &pBegin);
+        const uint32_t* pWords = pBegin;
+        HRESULT hresult = S_OK;
+        for (uint32_t i = 0; i < numDraws; ++i) {
+          const uint32_t op = *pWords++;
+          if (op & Commands::MultiDrawInputAssembly) {
+            pWords = applyInputAssembly(pD3DDevice, pWords, hresult);
+          }
+          if (op & Commands::MultiDrawTransformsAndLights) {
+            pWords = applyTransformsAndLights(pD3DDevice, pWords, hresult);
+          }
+          HRESULT hr;
+          if ((op & Commands::MultiDrawOpMask) == Commands::MultiDrawIndexedPrimitive) {
+            hr = pD3DDevice->DrawIndexedPrimitive(IN (D3DPRIMITIVETYPE) pWords[0], IN (INT) pWords[1],
+                                                  IN pWords[2], IN pWords[3], IN pWords[4], IN pWords[5]);
+            pWords += 6;
+          } else {
+            hr = pD3DDevice->DrawPrimitive(IN (D3DPRIMITIVETYPE) pWords[0], IN pWords[1], IN pWords[2]);
+            pWords += 3;
+          }
+          assert(SUCCEEDED(hr));
+          hresult = FAILED(hr) ? hr : hresult;
+        }
+        BRIDGE_VALIDATE_CHEAP((size_t) (pWords - pBegin) * sizeof(uint32_t) == size);
+        SEND_OPTIONAL_SERVER_RESPONSE(hresult, currentUID);
+        break;
+      }
       case IDirect3DDevice9Ex_CreatePixelShader:
       {
         GET_RES(pD3DDevice, gpD3DDevices);
@@ -1644,6 +1966,9 @@ void ProcessDeviceCommandQueue() {
         HWND hwnd = TRUNCATE_HANDLE(HWND, hDestinationWindow);
         const auto hresult = ((IDirect3DDevice9Ex*) pD3DDevice)->CheckDeviceState(IN hwnd);
         assert(SUCCEEDED(hresult));
+        if (hwnd == nullptr && DeviceStatus::isInitialized()) {
+          DeviceStatus::publishDeviceState(pD3DDeviceHandle, (uint32_t) hresult);
+        }
         {
           ServerMessage c(Commands::Bridge_Response, currentUID);
           c.send_data(hresult);
@@ -1715,6 +2040,7 @@ void ProcessDeviceCommandQueue() {
       case IDirect3DSwapChain9_Present:
       {
         FrameMark;
+        FrameTimeline::onServerPresentPulled();
 #ifdef ENABLE_PRESENT_SEMAPHORE_TRACE
         Logger::trace("Server side Present call received, releasing semaphore...");
 #endif
@@ -1729,15 +2055,31 @@ void ProcessDeviceCommandQueue() {
         HWND hwnd = TRUNCATE_HANDLE(HWND, hDestWindowOverride);
 
         const auto hresult = pSwapChain->Present(pSourceRect, pDestRect, hwnd, pDirtyRegion, dwFlags);
+        FrameTimeline::onServerPresentDone();
 
         if (!SUCCEEDED(hresult)) {
           std::stringstream ss;
           ss << "Present() failed! Check all logs for reported errors.";
         }
 
+        // GetDevice() adds a reference, drop it right away, the swap chain keeps
+        // the device alive
+        IDirect3DDevice9* pD3DDevice = nullptr;
+        if (SUCCEEDED(pSwapChain->GetDevice(&pD3DDevice))) {
+          pD3DDevice->Release();
+          // Swap chains don't carry their device's handle, it is looked up
+          // among the few live devices instead
+          for (const auto& [deviceHandle, pDevice] : gpD3DDevices) {
+            if (pDevice == pD3DDevice) {
+              publishDeviceStatus(pD3DDevice, deviceHandle);
+              break;
+            }
+          }
+        }
+
         // If we're syncing with the client on Present() then trigger the semaphore now
         if (GlobalOptions::getPresentSemaphoreEnabled()) {
-          gpPresent->release();
+          releasePresentSemaphore(pD3DDevice);
 #ifdef ENABLE_PRESENT_SEMAPHORE_TRACE
           Logger::trace("Present semaphore released successfully.");
 #endif
@@ -1977,6 +2319,7 @@ void ProcessDeviceCommandQueue() {
         GET_HND(pHandle);
         const auto& pTexture = (IDirect3DTexture9*) gpD3DResources[pHandle];
         safeDestroy(pTexture, pHandle);
+        gpD3DResources.unregisterChildren(pHandle);
         gpD3DResources.erase(pHandle);
         break;
       }
@@ -2078,6 +2421,7 @@ void ProcessDeviceCommandQueue() {
         GET_HND(pHandle);
         const auto& pVolumeTexture = (IDirect3DVolumeTexture9*) gpD3DResources[pHandle];
         safeDestroy(pVolumeTexture, pHandle);
+        gpD3DVolumes.unregisterChildren(pHandle);
         gpD3DResources.erase(pHandle);
         break;
       }
@@ -2217,6 +2561,7 @@ void ProcessDeviceCommandQueue() {
         GET_HND(pHandle);
         const auto& pCubeTexture = (IDirect3DCubeTexture9*) gpD3DResources[pHandle];
         safeDestroy(pCubeTexture, pHandle);
+        gpD3DResources.unregisterChildren(pHandle);
         gpD3DResources.erase(pHandle);
         break;
       }
@@ -2368,11 +2713,20 @@ void ProcessDeviceCommandQueue() {
         } else if (Commands::IsDataInSharedHeap(rpcHeader.flags)) {
           PULL_U(allocId);
           data = SharedHeap::getBuf(allocId) + OffsetToLock;
+        } else if (Commands::IsDataCompressed(rpcHeader.flags)) {
+          const auto size = DeviceBridge::get_data(&data);
+          // Decompress straight into the locked buffer
+          if (!Compression::decompress(data, size, pbData, SizeToLock)) {
+            Logger::err("Failed to decompress buffer data sent by the client!");
+          }
+          data = nullptr;
         } else {
           const auto size = DeviceBridge::get_data(&data);
           assert(SizeToLock == size);
         }
-        memcpy(pbData, data, SizeToLock);
+        if (data) {
+          memcpy(pbData, data, SizeToLock);
+        }
         hresult = pVertexBuffer->Unlock();
         assert(SUCCEEDED(hresult));
 
@@ -2454,11 +2808,20 @@ void ProcessDeviceCommandQueue() {
         } else if (Commands::IsDataInSharedHeap(rpcHeader.flags)) {
           PULL_U(allocId);
           data = SharedHeap::getBuf(allocId) + OffsetToLock;
+        } else if (Commands::IsDataCompressed(rpcHeader.flags)) {
+          const auto size = DeviceBridge::get_data(&data);
+          // Decompress straight into the locked buffer
+          if (!Compression::decompress(data, size, pbData, SizeToLock)) {
+            Logger::err("Failed to decompress buffer data sent by the client!");
+          }
+          data = nullptr;
         } else {
           const auto size = DeviceBridge::get_data(&data);
           assert(SizeToLock == size);
         }
-        memcpy(pbData, data, SizeToLock);
+        if (data) {
+          memcpy(pbData, data, SizeToLock);
+        }
         hresult = pIndexBuffer->Unlock();
         assert(SUCCEEDED(hresult));
         break;
@@ -2536,16 +2899,11 @@ void ProcessDeviceCommandQueue() {
         GET_HND(pHandle);
         PULL_OBJ(RECT, pRect);
         PULL_D(Flags);
+        PULL_D(dFormat);
+        PULL_D(IncomingPitch);
         const auto pSurface = (IDirect3DSurface9*) gpD3DResources[pHandle];
-        // Now lock the rect so we can copy the data into it
-        D3DLOCKED_RECT lockedRect;
-        auto hresult = pSurface->LockRect(OUT & lockedRect, IN pRect, IN Flags);
-        assert(S_OK == hresult);
-        // Copy the data over
         const uint32_t width = pRect->right - pRect->left;
         const uint32_t height = pRect->bottom - pRect->top;
-        PULL_D(dFormat);
-        PULL_D(IncomingPitch);
         const D3DFORMAT format = (D3DFORMAT) dFormat;
         const size_t rowSize = bridge_util::calcRowSize(width, format);
         void* pData = nullptr;
@@ -2554,23 +2912,116 @@ void ProcessDeviceCommandQueue() {
         // using the data queue then we've only allocated just enough 
         // space as the requested rect would fill. 
         const bool useSharedHeap = Commands::IsDataInSharedHeap(rpcHeader.flags);
+        const bool isCompressed = Commands::IsDataCompressed(rpcHeader.flags);
         if (useSharedHeap) {
           PULL_U(allocId);
           const size_t byteOffset = bridge_util::calcImageByteOffset(IncomingPitch, *pRect, format);
           pData = SharedHeap::getBuf(allocId) + byteOffset;
-        } else {
+        } else if (!isCompressed) {
           size_t pulledSize = DeviceBridge::get_data(&pData);
           const size_t numRows = bridge_util::calcStride(height, format);
           assert(pulledSize == numRows * IncomingPitch);
         }
-        FOR_EACH_RECT_ROW(lockedRect, height, format,
-          memcpy(ptr, (PBYTE) pData + y * IncomingPitch, rowSize);
-        )
+        // Uncompressed data can be staged without locking the surface at all
+        if (pData && StagingPool::upload(pSurface, *pRect, format, (const uint8_t*) pData, IncomingPitch, rowSize)) {
+          break;
+        }
+        // Staged transfers still pending for this surface must not land on
+        // top of the data written directly below
+        if (StagingPool::hasPending()) {
+          StagingPool::flush();
+        }
+        // Now lock the rect so we can copy the data into it
+        D3DLOCKED_RECT lockedRect;
+        auto hresult = pSurface->LockRect(OUT & lockedRect, IN pRect, IN Flags);
+        assert(S_OK == hresult);
+        if (isCompressed) {
+          void* pCompressed = nullptr;
+          const size_t compressedSize = DeviceBridge::get_data(&pCompressed);
+          const size_t numRows = bridge_util::calcStride(height, format);
+          const size_t uncompressedSize = numRows * IncomingPitch;
+          // Rows can be decompressed straight into the surface if the pitches
+          // line up, otherwise go through a scratch buffer
+          if ((size_t) lockedRect.Pitch == IncomingPitch) {
+            if (!Compression::decompress(pCompressed, compressedSize, lockedRect.pBits, uncompressedSize)) {
+              Logger::err("Failed to decompress surface data sent by the client!");
+            }
+          } else {
+            static std::vector<uint8_t> scratch;
+            if (scratch.size() < uncompressedSize) {
+              scratch.resize(uncompressedSize);
+            }
+            if (Compression::decompress(pCompressed, compressedSize, scratch.data(), uncompressedSize)) {
+              pData = scratch.data();
+            } else {
+              Logger::err("Failed to decompress surface data sent by the client!");
+            }
+          }
+        }
+        if (pData) {
+          FOR_EACH_RECT_ROW(lockedRect, height, format,
+            memcpy(ptr, (PBYTE) pData + y * IncomingPitch, rowSize);
+          )
+        }
         hresult = pSurface->UnlockRect();
         assert(SUCCEEDED(hresult));
 
         break;
       }
+      case IDirect3DSurface9_UnlockRects:
+      {
+        // Coalesced uploads of texture levels and cube faces, the command
+        // handle is the texture they belong to
+        PULL_U(numRects);
+        const uint32_t* pRects = nullptr;
+        const size_t rectsSize = DeviceBridge::get_data((void**) &pRects);
+        BRIDGE_VALIDATE_CHEAP(rectsSize == numRects * Commands::kUnlockRectsWordsPerRect * sizeof(uint32_t));
+        const uint8_t* pData = nullptr;
+        const size_t dataSize = DeviceBridge::get_data((void**) &pData);
+        if (Commands::IsDataCompressed(rpcHeader.flags)) {
+          size_t uncompressedSize = 0;
+          for (uint32_t i = 0; i < numRects; ++i) {
+            const uint32_t* pRect = pRects + i * Commands::kUnlockRectsWordsPerRect;
+            const uint32_t height = pRect[4] - pRect[2];
+            uncompressedSize += (size_t) bridge_util::calcStride(height, (D3DFORMAT) pRect[6]) * pRect[7];
+          }
+          static std::vector<uint8_t> scratch;
+          if (scratch.size() < uncompressedSize) {
+            scratch.resize(uncompressedSize);
+          }
+          if (!Compression::decompress(pData, dataSize, scratch.data(), uncompressedSize)) {
+            Logger::err("Failed to decompress surface data sent by the client!");
+            break;
+          }
+          pData = scratch.data();
+        }
+        for (uint32_t i = 0; i < numRects; ++i) {
+          const uint32_t* pRect = pRects + i * Commands::kUnlockRectsWordsPerRect;
+          const auto pSurface = (IDirect3DSurface9*) gpD3DResources[pRect[0]];
+          const RECT rect = { (LONG) pRect[1], (LONG) pRect[2], (LONG) pRect[3], (LONG) pRect[4] };
+          const DWORD flags = pRect[5];
+          const D3DFORMAT format = (D3DFORMAT) pRect[6];
+          const uint32_t rowSize = pRect[7];
+          const uint32_t height = rect.bottom - rect.top;
+          if (!StagingPool::upload(pSurface, rect, format, pData, rowSize, rowSize)) {
+            if (StagingPool::hasPending()) {
+              StagingPool::flush();
+            }
+            D3DLOCKED_RECT lockedRect;
+            auto hresult = pSurface->LockRect(OUT & lockedRect, IN & rect, IN flags);
+            assert(S_OK == hresult);
+            if (SUCCEEDED(hresult)) {
+              FOR_EACH_RECT_ROW(lockedRect, height, format,
+                memcpy(ptr, pData + y * rowSize, rowSize);
+              )
+              hresult = pSurface->UnlockRect();
+              assert(SUCCEEDED(hresult));
+            }
+          }
+          pData += (size_t) bridge_util::calcStride(height, format) * rowSize;
+        }
+        break;
+      }
       case IDirect3DSurface9_GetDC:
         break;
       case IDirect3DSurface9_ReleaseDC:
@@ -2765,6 +3216,7 @@ void ProcessDeviceCommandQueue() {
       {
         GET_HND(pHandle);
         gpD3DResources.erase(pHandle);
+        gpD3DVolumes.erase(pHandle);
         break;
       }
 
@@ -2786,8 +3238,12 @@ void ProcessDeviceCommandQueue() {
 
         const auto matInfoSType = remixapi::pullSType();
         assert(matInfoSType == REMIXAPI_STRUCT_TYPE_MATERIAL_INFO);
+        // Materials hold no handles, so the serialized payload fully identifies them
+        const bool bDedup = ServerOptions::getDedupRemixApiObjects();
+        remixapi::DedupKey contentKey;
+        remixapi::DedupKey* const pContentKey = bDedup ? &contentKey : nullptr;
         serialize::MaterialInfo matInfo;
-        deserializeFromQueue(matInfo);
+        deserializeFromQueue(matInfo, pContentKey);
         
         matInfo.pNext = nullptr;
 
@@ -2795,11 +3251,16 @@ void ProcessDeviceCommandQueue() {
         auto* pInfoProto = &getInfoProto(matInfo);
         while(bMatExtExists) {
           const auto extSType = remixapi::pullSType();
+          // The sType sent ahead of the payload is what picks the extension,
+          // so it is part of the material's identity
+          if (pContentKey) {
+            pContentKey->append(&extSType, sizeof(extSType));
+          }
           switch (extSType) {
             case REMIXAPI_STRUCT_TYPE_MATERIAL_INFO_OPAQUE_EXT:
             {
               assert(!exts.opaque.pNext);
-              deserializeFromQueue(exts.opaque);
+              deserializeFromQueue(exts.opaque, pContentKey);
               pInfoProto->pNext = &(exts.opaque);
               pInfoProto = &getInfoProto(exts.opaque);
               break;
@@ -2807,7 +3268,7 @@ void ProcessDeviceCommandQueue() {
             case REMIXAPI_STRUCT_TYPE_MATERIAL_INFO_OPAQUE_SUBSURFACE_EXT:
             {
               assert(!exts.opaqueSubsurface.pNext);
-              deserializeFromQueue(exts.opaqueSubsurface);
+              deserializeFromQueue(exts.opaqueSubsurface, pContentKey);
               pInfoProto->pNext = &(exts.opaqueSubsurface);
               pInfoProto = &getInfoProto(exts.opaqueSubsurface);
               break;
@@ -2815,7 +3276,7 @@ void ProcessDeviceCommandQueue() {
             case REMIXAPI_STRUCT_TYPE_MATERIAL_INFO_TRANSLUCENT_EXT:
             {
               assert(!exts.translucent.pNext);
-              deserializeFromQueue(exts.translucent);
+              deserializeFromQueue(exts.translucent, pContentKey);
               pInfoProto->pNext = &(exts.translucent);
               pInfoProto = &getInfoProto(exts.translucent);
               break;
@@ -2823,7 +3284,7 @@ void ProcessDeviceCommandQueue() {
             case REMIXAPI_STRUCT_TYPE_MATERIAL_INFO_PORTAL_EXT:
             {
               assert(!exts.portal.pNext);
-              deserializeFromQueue(exts.portal);
+              deserializeFromQueue(exts.portal, pContentKey);
               pInfoProto->pNext = &(exts.portal);
               pInfoProto = &getInfoProto(exts.portal);
               break;
@@ -2838,9 +3299,14 @@ void ProcessDeviceCommandQueue() {
         }
 
         auto bridgeHandle = DeviceBridge::get_data();
-        remixapi_MaterialHandle remixApiHandle = nullptr;
-        if(remixapi::g_remix.CreateMaterial(&matInfo, &remixApiHandle) == REMIXAPI_ERROR_CODE_SUCCESS) {
+        remixapi_MaterialHandle remixApiHandle = bDedup ? remixapi::g_materialCache.acquire(contentKey) : nullptr;
+        if(remixApiHandle) {
+          MaterialHandle(bridgeHandle, remixApiHandle);
+        } else if(remixapi::g_remix.CreateMaterial(&matInfo, &remixApiHandle) == REMIXAPI_ERROR_CODE_SUCCESS) {
           MaterialHandle(bridgeHandle, remixApiHandle);
+          if(bDedup) {
+            remixapi::g_materialCache.insert(std::move(contentKey), remixApiHandle);
+          }
         } else {
           Logger::err("[RemixApi_CreateMaterial] Remix API call failed!");
         }
@@ -2852,7 +3318,9 @@ void ProcessDeviceCommandQueue() {
       {
         MaterialHandle handle(DeviceBridge::get_data());
         if(handle.isValid()) {
-          remixapi::g_remix.DestroyMaterial(handle);
+          if(remixapi::g_materialCache.release(handle)) {
+            remixapi::g_remix.DestroyMaterial(handle);
+          }
           handle.invalidate();
         } else {
           Logger::err("[RemixApi_DestroyMaterial] Invalid material handle!" );
@@ -2878,10 +3346,20 @@ void ProcessDeviceCommandQueue() {
           surf.material = matHandle;
         }
 
+        // Meshes are keyed after material handles have been translated, so
+        // that meshes referencing deduplicated materials still match
+        const bool bDedup = ServerOptions::getDedupRemixApiObjects();
+        remixapi::DedupKey contentKey = bDedup ? remixapi::makeMeshKey(meshInfo) : remixapi::DedupKey {};
+
         auto bridgeHandle = DeviceBridge::get_data();
-        remixapi_MeshHandle remixApiHandle = nullptr;
-        if(remixapi::g_remix.CreateMesh(&meshInfo, &remixApiHandle) == REMIXAPI_ERROR_CODE_SUCCESS) {
+        remixapi_MeshHandle remixApiHandle = bDedup ? remixapi::g_meshCache.acquire(contentKey) : nullptr;
+        if(remixApiHandle) {
           MeshHandle handle(bridgeHandle, remixApiHandle);
+        } else if(remixapi::g_remix.CreateMesh(&meshInfo, &remixApiHandle) == REMIXAPI_ERROR_CODE_SUCCESS) {
+          MeshHandle handle(bridgeHandle, remixApiHandle);
+          if(bDedup) {
+            remixapi::g_meshCache.insert(std::move(contentKey), remixApiHandle);
+          }
         } else {
           Logger::err("[RemixApi_CreateMesh] Remix API call failed!");
         }
@@ -2893,7 +3371,9 @@ void ProcessDeviceCommandQueue() {
       {
         MeshHandle handle(DeviceBridge::get_data());
         if(handle.isValid()) {
-          remixapi::g_remix.DestroyMesh(handle);
+          if(remixapi::g_meshCache.release(handle)) {
+            remixapi::g_remix.DestroyMesh(handle);
+          }
           handle.invalidate();
         } else {
           Logger::err("[RemixApi_DestroyMesh] Invalid mesh handle!" );
@@ -3131,12 +3611,13 @@ void ProcessDeviceCommandQueue() {
       }
     }
 
+    // Any Remix API structs deserialized above went out of scope with their
+    // case block, so the memory backing their arrays can be recycled now
+    DeserializeArena::reset();
+
     // Ensure the data position between client and server is in sync after processing the command
-    if (!CHECK_DATA_OFFSET)       {
-      Logger::warn("Data not in sync");
-    }
-    assert(CHECK_DATA_OFFSET);
-    *DeviceBridge::getReaderChannel().serverDataPos = DeviceBridge::get_data_pos();
+    BRIDGE_VALIDATE_CHEAP(CHECK_DATA_OFFSET);
+    publishServerDataPos();
     // Check if overwrite condition was met
     if (*DeviceBridge::getReaderChannel().clientDataExpectedPos != -1) {
       if (!gOverwriteConditionAlreadyActive) {
@@ -3171,6 +3652,7 @@ void ProcessDeviceCommandQueue() {
   // Check if we exited the command processing loop unexpectedly while the bridge is still enabled
   if (!done && gbBridgeRunning) {
     Logger::debug("The device command processing loop was exited unexpectedly, either due to timing out or some other command queue issue.");
+    CommandHistory::dump();
   }
 }
 
@@ -3299,6 +3781,7 @@ void CALLBACK OnClientExited(void* context, BOOLEAN isTimeout) {
   ModuleBridge::Command::print_reader_data_sent();
   Logger::info("Most recent Module Queue commands received by Server");
   ModuleBridge::Command::print_reader_data_received();
+  CommandHistory::dump();
 
   // Give the server some time to shut down, but then force quit so it doesn't hang forever
   uint32_t numRetries = 0;
@@ -3413,19 +3896,44 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
   }
   LocalFree(argList);
 
-  initModuleBridge();
-  initDeviceBridge();
+  // Loading d3d9.dll, which could be original system, dxvk-remix, or something
+  // else, is by far the most expensive startup step. It only depends on config
+  // and logging being set up, so kick it off right away and let it run while
+  // the bridge channels are created and the client handshake is in flight.
+  Logger::info("Initializing D3D9...");
+  auto initD3DResult = std::async(std::launch::async, []() {
+    ScopedPhaseTimer timer("InitializeD3D");
+    return InitializeD3D();
+  });
 
-  if (GlobalOptions::getUseSharedHeap()) {
-    SharedHeap::init();
-  }
+  {
+    ScopedPhaseTimer timer("Bridge channel setup");
+    initModuleBridge();
+    initDeviceBridge();
 
-  gpPresent = new NamedSemaphore("Present", GlobalOptions::getPresentSemaphoreMaxFrames(), GlobalOptions::getPresentSemaphoreMaxFrames());
+    if (GlobalOptions::getUseSharedHeap()) {
+      SharedHeap::init();
+    }
+
+    gpPresent = new NamedSemaphore("Present", GlobalOptions::getPresentSemaphoreMaxFrames(), GlobalOptions::getPresentSemaphoreMaxFrames());
+
+    if (GlobalOptions::getCacheDeviceStatus()) {
+      DeviceStatus::init();
+    }
+
+    if (GlobalOptions::getFrameTimeline()) {
+      FrameTimeline::init();
+    }
+  }
 
   // Initialize our shared client command queue as a Reader.
   // (1) Wait for connection for client.
   Logger::info("Server started up, waiting for connection from client...");
-  const auto waitForSynResult = DeviceBridge::waitForCommand(Bridge_Syn, GlobalOptions::getStartupTimeout());
+  Result waitForSynResult;
+  {
+    ScopedPhaseTimer timer("Waiting for client SYN");
+    waitForSynResult = DeviceBridge::waitForCommand(Bridge_Syn, GlobalOptions::getStartupTimeout());
+  }
   switch (waitForSynResult) {
   case Result::Timeout:
   {
@@ -3449,10 +3957,12 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
 
   RegisterMessageChannel();
 
-  // (2) Load d3d9.dll, which could be original system, dxvk-remix, or something else...
-  Logger::info("Initializing D3D9...");
-  if (!InitializeD3D()) {
-    return 1;
+  // (2) Wait for d3d9.dll to finish loading before acknowledging the client
+  {
+    ScopedPhaseTimer timer("Waiting for D3D9 initialization");
+    if (!initD3DResult.get()) {
+      return 1;
+    }
   }
 
   // (3) Send ACK to Client. Connection has been established
@@ -3480,12 +3990,23 @@ int WINAPI wWinMain(_In_ HINSTANCE hInstance, _In_opt_ HINSTANCE hPrevInstance,
   }
   // (5) Ready to listen for incoming commands
   Logger::info("Handshake completed! Now waiting for incoming commands...");
+  Logger::info(format_string("[Startup] Server ready after %.2f ms",
+    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - gTimeStart).count() / 1000.0));
+
+  ThreadPlacement::applyProcessPriorityClass(ServerOptions::getProcessPriorityClass());
+  const auto placement = ThreadPlacement::parseStrategy(ServerOptions::getThreadPlacement());
 
   std::atomic<bool> bSignalDone(false);
   auto moduleCmdProcessingThread = std::thread([&]() {
+    ThreadPlacement::applyToCurrentThread(ThreadPlacement::Worker::Module, placement,
+                                          ServerOptions::getModuleThreadCpus(),
+                                          ServerOptions::getModuleThreadPriority());
     processModuleCommandQueue(&bSignalDone);
   });
   // Process device commands
+  ThreadPlacement::applyToCurrentThread(ThreadPlacement::Worker::Device, placement,
+                                        ServerOptions::getDeviceThreadCpus(),
+                                        ServerOptions::getDeviceThreadPriority());
   ProcessDeviceCommandQueue();
   bSignalDone.store(true);
   moduleCmdProcessingThread.join();
@@ -7,7 +7,9 @@
 #include "remix_api.h"
 
 #include "util_bridge_assert.h"
+#include "util_commandhistory.h"
 #include "util_modulecommand.h"
+#include "util_validation.h"
 
 #include "log/log.h"
 
@@ -25,23 +27,23 @@ extern LPDIRECT3D9 gpD3D;
 #define PULL_H(name) PULL(HRESULT, name)
 #define PULL_HND(name) \
             PULL_U(name); \
-            assert(name != NULL)
+            BRIDGE_VALIDATE_CHEAP(name != NULL)
 #define PULL_DATA(size, name) \
             uint32_t name##_len = ModuleBridge::get_data((void**)&name); \
-            assert(name##_len == 0 || size == name##_len)
+            BRIDGE_VALIDATE_CHEAP(name##_len == 0 || size == name##_len)
 #define PULL_OBJ(type, name) \
             type* name = nullptr; \
             PULL_DATA(sizeof(type), name)
 #define CHECK_DATA_OFFSET (ModuleBridge::get_data_pos() == rpcHeader.dataOffset)
 #define GET_HND(name) \
             const auto& name = rpcHeader.pHandle; \
-            assert(name != NULL)
+            BRIDGE_VALIDATE_CHEAP(name != NULL)
 #define GET_HDR_VAL(name) \
             const DWORD& name = rpcHeader.pHandle;
 #define GET_RES(name, map) \
             GET_HND(name##Handle); \
             const auto& name = map[name##Handle]; \
-            assert(name != NULL)
+            BRIDGE_VALIDATE_CHEAP(name != NULL)
 
 // NOTE: MSDN states HWNDs are safe to cross x86-->x64 boundary, and that a truncating cast should be used: https://docs.microsoft.com/en-us/windows/win32/winprog64/interprocess-communication?redirectedfrom=MSDN
 #define TRUNCATE_HANDLE(type, input) (type)(size_t)(input)
@@ -79,6 +81,8 @@ void processModuleCommandQueue(std::atomic<bool>* const pbSignalEnd) {
     Commands::Bridge_Any, 0, pbSignalEnd))) {
     const Header rpcHeader = ModuleBridge::pop_front();
     PULL_U(currentUID);
+    CommandHistory::record('M', CommandHistory::Direction::Received, rpcHeader.command, currentUID,
+                           ModuleBridge::get_pending_data_size(rpcHeader.dataOffset));
 #if defined(_DEBUG) || defined(DEBUGOPT)
     if (GlobalOptions::getLogServerCommands()) {
       Logger::info("Module Processing: " + toString(rpcHeader.command) + " UID: " + std::to_string(currentUID));
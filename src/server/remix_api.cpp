@@ -30,6 +30,8 @@ namespace remixapi {
   HMODULE g_remix_dll = nullptr;
   IDirect3DDevice9Ex* g_device = nullptr;
   std::mutex g_device_mutex;
+  DedupCache<remixapi_MaterialHandle> g_materialCache;
+  DedupCache<remixapi_MeshHandle> g_meshCache;
 
   IDirect3DDevice9Ex* getDevice() {
     std::scoped_lock device_lock(g_device_mutex);
@@ -41,4 +43,29 @@ namespace remixapi {
     bridge_util::Logger::info("[RemixApi] getDevice(): failed");
     return nullptr;
   }
+
+  DedupKey makeMeshKey(const remixapi_MeshInfo& meshInfo) {
+    DedupKey key;
+    key.append(&meshInfo.hash, sizeof(meshInfo.hash));
+    key.append(&meshInfo.surfaces_count, sizeof(meshInfo.surfaces_count));
+    for (size_t iSurf = 0; iSurf < meshInfo.surfaces_count; ++iSurf) {
+      const auto& surf = meshInfo.surfaces_values[iSurf];
+      key.append(&surf.vertices_count, sizeof(surf.vertices_count));
+      key.append(surf.vertices_values, surf.vertices_count * sizeof(remixapi_HardcodedVertex));
+      key.append(&surf.indices_count, sizeof(surf.indices_count));
+      key.append(surf.indices_values, surf.indices_count * sizeof(uint32_t));
+      key.append(&surf.skinning_hasvalue, sizeof(surf.skinning_hasvalue));
+      if (surf.skinning_hasvalue) {
+        const auto& skinning = surf.skinning_value;
+        const size_t numElements = surf.vertices_count * skinning.bonesPerVertex;
+        key.append(&skinning.bonesPerVertex, sizeof(skinning.bonesPerVertex));
+        key.append(&skinning.blendWeights_count, sizeof(skinning.blendWeights_count));
+        key.append(skinning.blendWeights_values, numElements * skinning.blendWeights_count * sizeof(float));
+        key.append(&skinning.blendIndices_count, sizeof(skinning.blendIndices_count));
+        key.append(skinning.blendIndices_values, numElements * skinning.blendIndices_count * sizeof(uint32_t));
+      }
+      key.append(&surf.material, sizeof(surf.material));
+    }
+    return key;
+  }
 }
@@ -23,6 +23,7 @@
 
 #include <remixapi/bridge_remix_api.h>
 
+#include "remix_api_dedup.h"
 #include "util_devicecommand.h"
 #include "util_remixapi.h"
 
@@ -35,6 +36,13 @@ namespace remixapi {
   extern IDirect3DDevice9Ex* g_device;
   extern std::mutex g_device_mutex;
   extern IDirect3DDevice9Ex* getDevice();
+
+  // Builds the key of a deserialized remixapi_MeshInfo, with material handles
+  // already translated to their Remix counterparts.
+  DedupKey makeMeshKey(const remixapi_MeshInfo& meshInfo);
+
+  extern DedupCache<remixapi_MaterialHandle> g_materialCache;
+  extern DedupCache<remixapi_MeshHandle> g_meshCache;
   
   static inline remixapi_StructType pullSType() {
     return (remixapi_StructType) DeviceBridge::get_data();
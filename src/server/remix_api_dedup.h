@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstring>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace remixapi {
+  // Cheap 64-bit hash used to look up deduplicated Remix API objects by content.
+  // Consumes 8 bytes per step, so it is fast enough for large mesh payloads.
+  static inline uint64_t hashBytes(const void* pData, const size_t size, uint64_t seed = 14695981039346656037ull) {
+    constexpr uint64_t kPrime = 1099511628211ull;
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      memcpy(&word, pBytes + i, sizeof(uint64_t));
+      seed = (seed ^ word) * kPrime;
+      seed ^= seed >> 29;
+    }
+    for (; i < size; ++i) {
+      seed = (seed ^ pBytes[i]) * kPrime;
+    }
+    return (seed ^ size) * kPrime;
+  }
+
+  // Content of a Remix API object as seen by the deduplication cache. The
+  // hash only selects the cache entry, the bytes are compared on every hit so
+  // that a hash collision can never alias two different objects.
+  struct DedupKey {
+    uint64_t hash = hashBytes(nullptr, 0);
+    std::vector<uint8_t> bytes;
+
+    void append(const void* pData, const size_t size) {
+      hash = hashBytes(pData, size, hash);
+      const auto* const pBytes = static_cast<const uint8_t*>(pData);
+      bytes.insert(bytes.end(), pBytes, pBytes + size);
+    }
+  };
+
+  // Maps the contents of created Remix objects to their handles, so that
+  // repeated creation of byte-identical objects can be served by the existing
+  // object. Every client handle aliasing the object holds one reference, and
+  // the Remix object is only destroyed once the last alias is gone.
+  template<typename RemixHandleT>
+  class DedupCache {
+  public:
+    // Returns the cached handle for the given key and takes a reference on
+    // it, or nullptr if no object with the same contents exists.
+    RemixHandleT acquire(const DedupKey& key) {
+      auto it = m_entries.find(key.hash);
+      if (it == m_entries.end() || it->second.bytes != key.bytes) {
+        return nullptr;
+      }
+      ++it->second.refCount;
+      return it->second.handle;
+    }
+
+    // On a hash collision with a different cached object the new object is
+    // simply left uncached.
+    void insert(DedupKey&& key, const RemixHandleT handle) {
+      const auto [it, bInserted] = m_entries.try_emplace(key.hash, Entry { handle, 1, std::move(key.bytes) });
+      if (bInserted) {
+        m_keys[handle] = key.hash;
+      }
+    }
+
+    // Drops one reference and returns true if the caller should destroy
+    // the Remix object, either because it was the last reference or because
+    // the object was never cached.
+    bool release(const RemixHandleT handle) {
+      auto keyIt = m_keys.find(handle);
+      if (keyIt == m_keys.end()) {
+        return true;
+      }
+      auto it = m_entries.find(keyIt->second);
+      if (--it->second.refCount > 0) {
+        return false;
+      }
+      m_entries.erase(it);
+      m_keys.erase(keyIt);
+      return true;
+    }
+
+  private:
+    struct Entry {
+      RemixHandleT handle;
+      uint32_t refCount;
+      std::vector<uint8_t> bytes;
+    };
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::unordered_map<RemixHandleT, uint64_t> m_keys;
+  };
+}
@@ -24,6 +24,8 @@
 #include "config/config.h"
 #include "log/log.h"
 
+#include <algorithm>
+
 namespace ServerOptions {
   inline bool getUseVanillaDxvk() {
     static const bool useVanillaDxvk =
@@ -48,4 +50,70 @@ namespace ServerOptions {
       bridge_util::Config::getOption<uint32_t>("server.shutdownRetries", 50);
     return shutdownRetries;
   }
-}
\ No newline at end of file
+
+  // Remix API clients frequently create byte-identical materials and meshes
+  // over and over. When enabled the server keeps a copy of their contents and
+  // serves repeated creations with the already existing Remix object, which
+  // for meshes also avoids the redundant upload and acceleration structure
+  // build. Contents are compared in full, the hash only speeds up the lookup.
+  inline bool getDedupRemixApiObjects() {
+    static const bool dedupRemixApiObjects =
+      bridge_util::Config::getOption<bool>("server.dedupRemixApiObjects", true);
+    return dedupRemixApiObjects;
+  }
+
+  // Placement of the device and module command processing threads, see
+  // thread_placement.h for the available strategies. Explicit lists of
+  // logical processors take precedence over the strategy.
+  inline std::string getThreadPlacement() {
+    static const std::string threadPlacement =
+      bridge_util::Config::getOption<std::string>("server.threadPlacement", "Default");
+    return threadPlacement;
+  }
+  inline std::vector<size_t> getDeviceThreadCpus() {
+    static const std::vector<size_t> deviceThreadCpus =
+      bridge_util::Config::getOption<std::vector<size_t>>("server.deviceThreadCpus");
+    return deviceThreadCpus;
+  }
+  inline std::vector<size_t> getModuleThreadCpus() {
+    static const std::vector<size_t> moduleThreadCpus =
+      bridge_util::Config::getOption<std::vector<size_t>>("server.moduleThreadCpus");
+    return moduleThreadCpus;
+  }
+  inline int32_t getDeviceThreadPriority() {
+    static const int32_t deviceThreadPriority =
+      bridge_util::Config::getOption<int32_t>("server.deviceThreadPriority", 0);
+    return deviceThreadPriority;
+  }
+  inline int32_t getModuleThreadPriority() {
+    static const int32_t moduleThreadPriority =
+      bridge_util::Config::getOption<int32_t>("server.moduleThreadPriority", 0);
+    return moduleThreadPriority;
+  }
+  inline std::string getProcessPriorityClass() {
+    static const std::string processPriorityClass =
+      bridge_util::Config::getOption<std::string>("server.processPriorityClass", "");
+    return processPriorityClass;
+  }
+
+  // Number of queued commands whose data the device thread prefetches while
+  // it executes the current one.
+  inline uint32_t getCommandLookahead() {
+    static const uint32_t commandLookahead =
+      std::min(bridge_util::Config::getOption<uint32_t>("server.commandLookahead", 4), 64u);
+    return commandLookahead;
+  }
+
+  // Uploads into default pool surfaces go through a pool of system memory
+  // staging surfaces and UpdateSurface, see staging_pool.h.
+  inline bool getUseStagingPool() {
+    static const bool useStagingPool =
+      bridge_util::Config::getOption<bool>("server.useStagingPool", true);
+    return useStagingPool;
+  }
+  inline uint32_t getStagingPoolMaxMB() {
+    static const uint32_t stagingPoolMaxMB =
+      bridge_util::Config::getOption<uint32_t>("server.stagingPoolMaxMB", 64);
+    return stagingPoolMaxMB;
+  }
+}
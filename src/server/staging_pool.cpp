@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "staging_pool.h"
+#include "server_options.h"
+
+#include "log/log.h"
+#include "util_texture_and_volume.h"
+
+#include <map>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+using namespace bridge_util;
+
+namespace StagingPool {
+  namespace {
+    // Staging surfaces are shared by all rects that fit into the same power
+    // of two size class, which keeps the number of surfaces in the pool low
+    struct SizeClass {
+      IDirect3DDevice9* pDevice;
+      D3DFORMAT format;
+      uint32_t width;
+      uint32_t height;
+
+      bool operator<(const SizeClass& other) const {
+        return std::tie(pDevice, format, width, height) <
+               std::tie(other.pDevice, other.format, other.width, other.height);
+      }
+    };
+
+    struct Transfer {
+      IDirect3DDevice9* pDevice;
+      IDirect3DSurface9* pStaging;
+      IDirect3DSurface9* pDst;
+      RECT srcRect;
+      POINT dstPoint;
+      SizeClass sizeClass;
+    };
+
+    std::map<SizeClass, std::vector<IDirect3DSurface9*>> gFreeSurfaces;
+    std::vector<Transfer> gPendingTransfers;
+    // Formats the runtime refused to create staging surfaces in
+    std::unordered_set<D3DFORMAT> gUnsupportedFormats;
+    size_t gTotalSize = 0;
+
+    uint32_t getSizeClass(const uint32_t size) {
+      // Block compressed formats need at least one full block
+      uint32_t sizeClass = 4;
+      while (sizeClass < size) {
+        sizeClass <<= 1;
+      }
+      return sizeClass;
+    }
+
+    IDirect3DSurface9* acquire(const SizeClass& sizeClass) {
+      auto& freeSurfaces = gFreeSurfaces[sizeClass];
+      if (!freeSurfaces.empty()) {
+        IDirect3DSurface9* const pStaging = freeSurfaces.back();
+        freeSurfaces.pop_back();
+        return pStaging;
+      }
+
+      static const size_t maxSize = (size_t) ServerOptions::getStagingPoolMaxMB() << 20;
+      const size_t size = calcTotalSizeOfRect(sizeClass.width, sizeClass.height, sizeClass.format);
+      if (gTotalSize + size > maxSize) {
+        return nullptr;
+      }
+      IDirect3DSurface9* pStaging = nullptr;
+      const auto hresult = sizeClass.pDevice->CreateOffscreenPlainSurface(sizeClass.width, sizeClass.height,
+                                                                           sizeClass.format, D3DPOOL_SYSTEMMEM,
+                                                                           &pStaging, nullptr);
+      if (FAILED(hresult)) {
+        Logger::info(format_string("StagingPool: Format %d not supported for staging surfaces, "
+                                   "uploading directly instead.", sizeClass.format));
+        gUnsupportedFormats.insert(sizeClass.format);
+        return nullptr;
+      }
+      gTotalSize += size;
+      return pStaging;
+    }
+  }
+
+  bool upload(IDirect3DSurface9* const pDst, const RECT& rect, const D3DFORMAT format,
+              const uint8_t* const pRows, const uint32_t srcPitch, const uint32_t rowSize) {
+    if (!ServerOptions::getUseStagingPool() || gUnsupportedFormats.count(format) != 0) {
+      return false;
+    }
+
+    // UpdateSurface can only write to non-multisampled color surfaces in
+    // the default pool, of the same format as the source
+    D3DSURFACE_DESC desc;
+    if (FAILED(pDst->GetDesc(&desc)) ||
+        desc.Pool != D3DPOOL_DEFAULT ||
+        desc.MultiSampleType != D3DMULTISAMPLE_NONE ||
+        (desc.Usage & D3DUSAGE_DEPTHSTENCIL) != 0 ||
+        desc.Format != format) {
+      return false;
+    }
+
+    // The surface keeps its device alive, so the reference can be dropped
+    // right away
+    IDirect3DDevice9* pDevice = nullptr;
+    if (FAILED(pDst->GetDevice(&pDevice))) {
+      return false;
+    }
+    pDevice->Release();
+
+    const uint32_t width = rect.right - rect.left;
+    const uint32_t height = rect.bottom - rect.top;
+    const SizeClass sizeClass { pDevice, format, getSizeClass(width), getSizeClass(height) };
+    IDirect3DSurface9* pStaging = acquire(sizeClass);
+    if (pStaging == nullptr) {
+      // Staging surfaces of queued transfers are returned to the pool once
+      // issued, so try again after that before giving up
+      if (gPendingTransfers.empty()) {
+        return false;
+      }
+      flush();
+      pStaging = acquire(sizeClass);
+      if (pStaging == nullptr) {
+        return false;
+      }
+    }
+
+    const RECT srcRect { 0, 0, (LONG) width, (LONG) height };
+    D3DLOCKED_RECT lockedRect;
+    if (FAILED(pStaging->LockRect(&lockedRect, &srcRect, 0))) {
+      gFreeSurfaces[sizeClass].push_back(pStaging);
+      return false;
+    }
+    FOR_EACH_RECT_ROW(lockedRect, height, format,
+      memcpy(ptr, pRows + y * srcPitch, rowSize);
+    )
+    pStaging->UnlockRect();
+
+    gPendingTransfers.push_back({ pDevice, pStaging, pDst, srcRect, POINT { rect.left, rect.top }, sizeClass });
+    return true;
+  }
+
+  bool hasPending() {
+    return !gPendingTransfers.empty();
+  }
+
+  void flush() {
+    for (auto& transfer : gPendingTransfers) {
+      const auto hresult = transfer.pDevice->UpdateSurface(transfer.pStaging, &transfer.srcRect,
+                                                           transfer.pDst, &transfer.dstPoint);
+      if (FAILED(hresult)) {
+        Logger::err(format_string("StagingPool: UpdateSurface() failed with error code 0x%x", hresult));
+      }
+      gFreeSurfaces[transfer.sizeClass].push_back(transfer.pStaging);
+    }
+    gPendingTransfers.clear();
+  }
+
+  void releaseDevice(IDirect3DDevice9* const pDevice) {
+    flush();
+    for (auto it = gFreeSurfaces.begin(); it != gFreeSurfaces.end();) {
+      if (it->first.pDevice != pDevice) {
+        ++it;
+        continue;
+      }
+      const size_t size = calcTotalSizeOfRect(it->first.width, it->first.height, it->first.format);
+      for (IDirect3DSurface9* const pStaging : it->second) {
+        pStaging->Release();
+        gTotalSize -= size;
+      }
+      it = gFreeSurfaces.erase(it);
+    }
+  }
+}
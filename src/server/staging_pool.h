@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <d3d9.h>
+
+#include <stdint.h>
+
+// Pool of D3DPOOL_SYSTEMMEM staging surfaces for uploads into D3DPOOL_DEFAULT
+// surfaces.
+//
+// Instead of locking the destination surface for every upload, which makes
+// the runtime stage and synchronize each one on its own, the rows are copied
+// into a pooled staging surface of the same format and size class, and the
+// transfers into the destination surfaces are queued and issued back to back
+// with UpdateSurface. This lets the runtime pipeline the GPU copies.
+//
+// Queued transfers must be issued before any command other than a surface
+// upload is processed, so that nothing can observe the destination surfaces
+// before their data has landed, and before any surface is written directly
+// when upload() declines it, so older staged data cannot land on top.
+namespace StagingPool {
+  // Copies the rows of the given rect into a staging surface and queues its
+  // transfer into pDst. Returns false if pDst cannot be updated this way, in
+  // which case it has to be locked and written directly.
+  bool upload(IDirect3DSurface9* const pDst, const RECT& rect, const D3DFORMAT format,
+              const uint8_t* const pRows, const uint32_t srcPitch, const uint32_t rowSize);
+
+  bool hasPending();
+
+  // Issues the queued transfers
+  void flush();
+
+  // Releases the staging surfaces of a device that is about to be destroyed
+  void releaseDevice(IDirect3DDevice9* const pDevice);
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "thread_placement.h"
+
+#include "log/log.h"
+
+#include <algorithm>
+#include <memory>
+
+using namespace bridge_util;
+
+namespace ThreadPlacement {
+  namespace {
+    // Physical cores of the highest efficiency class, i.e. the performance
+    // cores on hybrid CPUs and simply all cores otherwise
+    std::vector<GROUP_AFFINITY> getPerformanceCores() {
+      std::vector<GROUP_AFFINITY> cores;
+
+      DWORD length = 0;
+      GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+      if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) {
+        Logger::warn("ThreadPlacement: Unable to query processor information.");
+        return cores;
+      }
+      auto buffer = std::make_unique<uint8_t[]>(length);
+      auto* const pInfo = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.get());
+      if (!GetLogicalProcessorInformationEx(RelationProcessorCore, pInfo, &length)) {
+        Logger::warn("ThreadPlacement: Unable to query processor information.");
+        return cores;
+      }
+
+      BYTE maxEfficiencyClass = 0;
+      for (DWORD offset = 0; offset < length;) {
+        const auto* const pCore = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.get() + offset);
+        maxEfficiencyClass = std::max(maxEfficiencyClass, pCore->Processor.EfficiencyClass);
+        offset += pCore->Size;
+      }
+      for (DWORD offset = 0; offset < length;) {
+        const auto* const pCore = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.get() + offset);
+        if (pCore->Processor.EfficiencyClass == maxEfficiencyClass) {
+          cores.push_back(pCore->Processor.GroupMask[0]);
+        }
+        offset += pCore->Size;
+      }
+      return cores;
+    }
+
+    bool setAffinity(const GROUP_AFFINITY& affinity) {
+      GROUP_AFFINITY groupAffinity = {};
+      groupAffinity.Group = affinity.Group;
+      groupAffinity.Mask = affinity.Mask;
+      return SetThreadGroupAffinity(GetCurrentThread(), &groupAffinity, nullptr) != FALSE;
+    }
+
+    const char* toString(const Worker worker) {
+      return worker == Worker::Device ? "device" : "module";
+    }
+  }
+
+  Strategy parseStrategy(const std::string& strategyStr) {
+    if (strategyStr == "PerformanceCores") {
+      return Strategy::PerformanceCores;
+    } else if (strategyStr == "SharedPhysicalCore") {
+      return Strategy::SharedPhysicalCore;
+    } else if (strategyStr == "SeparatePhysicalCores") {
+      return Strategy::SeparatePhysicalCores;
+    } else if (strategyStr != "Default") {
+      Logger::warn("ThreadPlacement: Unknown strategy: " + strategyStr);
+    }
+    return Strategy::Default;
+  }
+
+  void applyToCurrentThread(const Worker worker,
+                            const Strategy strategy,
+                            const std::vector<size_t>& cpus,
+                            const int priority) {
+    if (priority != THREAD_PRIORITY_NORMAL) {
+      if (!SetThreadPriority(GetCurrentThread(), priority)) {
+        Logger::warn(format_string("ThreadPlacement: Unable to set %s thread priority to %d.",
+                                   toString(worker), priority));
+      }
+    }
+
+    GROUP_AFFINITY affinity = {};
+    if (!cpus.empty()) {
+      for (const size_t cpu : cpus) {
+        if (cpu < sizeof(KAFFINITY) * 8) {
+          affinity.Mask |= KAFFINITY(1) << cpu;
+        }
+      }
+    } else if (strategy != Strategy::Default) {
+      const auto cores = getPerformanceCores();
+      if (cores.empty()) {
+        return;
+      }
+      switch (strategy) {
+      case Strategy::PerformanceCores:
+        // Affinity may not span processor groups, so stick to the first one
+        affinity.Group = cores[0].Group;
+        for (const auto& core : cores) {
+          if (core.Group == affinity.Group) {
+            affinity.Mask |= core.Mask;
+          }
+        }
+        break;
+      case Strategy::SharedPhysicalCore:
+        affinity = cores[0];
+        break;
+      case Strategy::SeparatePhysicalCores:
+        affinity = cores[static_cast<size_t>(worker) % cores.size()];
+        break;
+      default:
+        break;
+      }
+    }
+
+    if (affinity.Mask == 0) {
+      return;
+    }
+    if (setAffinity(affinity)) {
+      Logger::info(format_string("ThreadPlacement: %s thread affinity set to group %d mask 0x%llx.",
+                                 toString(worker), affinity.Group, (uint64_t) affinity.Mask));
+    } else {
+      Logger::warn(format_string("ThreadPlacement: Unable to set %s thread affinity to group %d mask 0x%llx.",
+                                 toString(worker), affinity.Group, (uint64_t) affinity.Mask));
+    }
+  }
+
+  void applyProcessPriorityClass(const std::string& priorityClassStr) {
+    DWORD priorityClass;
+    if (priorityClassStr.empty()) {
+      return;
+    } else if (priorityClassStr == "Normal") {
+      priorityClass = NORMAL_PRIORITY_CLASS;
+    } else if (priorityClassStr == "AboveNormal") {
+      priorityClass = ABOVE_NORMAL_PRIORITY_CLASS;
+    } else if (priorityClassStr == "High") {
+      priorityClass = HIGH_PRIORITY_CLASS;
+    } else {
+      Logger::warn("ThreadPlacement: Unknown process priority class: " + priorityClassStr);
+      return;
+    }
+    if (!SetPriorityClass(GetCurrentProcess(), priorityClass)) {
+      Logger::warn("ThreadPlacement: Unable to set process priority class to " + priorityClassStr);
+    }
+  }
+}
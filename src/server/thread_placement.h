@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <windows.h>
+
+#include <string>
+#include <vector>
+
+// Placement of the server's command processing threads onto CPU cores.
+//
+// The device and module command threads busy-wait against the client's
+// submitting threads, so which cores they land on may affect latency,
+// especially on hybrid CPUs where the scheduler is free to move them onto
+// efficiency cores. The strategies are unmeasured, which is why Default,
+// i.e. leaving placement to the OS, stays the default.
+namespace ThreadPlacement {
+  enum class Strategy {
+    // Leave placement to the OS scheduler
+    Default,
+    // Restrict the threads to the highest performance class cores
+    PerformanceCores,
+    // Put all bridge threads onto the logical processors of one performance
+    // core, so that they share its caches
+    SharedPhysicalCore,
+    // Give each bridge thread a performance core of its own
+    SeparatePhysicalCores
+  };
+
+  enum class Worker : uint32_t {
+    Device = 0,
+    Module = 1
+  };
+
+  Strategy parseStrategy(const std::string& strategyStr);
+
+  // Applies the placement to the calling thread. An explicit list of logical
+  // processors (in processor group 0) takes precedence over the strategy.
+  // A priority of THREAD_PRIORITY_NORMAL leaves the priority untouched.
+  void applyToCurrentThread(const Worker worker,
+                            const Strategy strategy,
+                            const std::vector<size_t>& cpus,
+                            const int priority);
+
+  // Sets the priority class of the server process, "Normal", "AboveNormal"
+  // and "High" are accepted. Empty string leaves it untouched.
+  void applyProcessPriorityClass(const std::string& priorityClassStr);
+}
@@ -44,6 +44,8 @@ void GlobalOptions::initSharedHeapPolicy() {
           sharedHeapPolicy |= SharedHeapPolicy::DynamicBuffers;
         } else if (policyStr == "StaticBuffers") {
           sharedHeapPolicy |= SharedHeapPolicy::StaticBuffers;
+        } else if (policyStr == "DrawUP") {
+          sharedHeapPolicy |= SharedHeapPolicy::DrawUP;
         } else {
           bridge_util::Logger::warn("Unknown shared heap policy string: " + policyStr);
         }
@@ -53,6 +55,15 @@ void GlobalOptions::initSharedHeapPolicy() {
     const bool bPolicyTextures = sharedHeapPolicy & SharedHeapPolicy::Textures;
           bool bPolicyDynamicBufs = sharedHeapPolicy & SharedHeapPolicy::DynamicBuffers;
     const bool bPolicyStaticBufs = sharedHeapPolicy & SharedHeapPolicy::StaticBuffers;
+          bool bPolicyDrawUP = sharedHeapPolicy & SharedHeapPolicy::DrawUP;
+
+    // DrawUP allocations are recycled based on the Present semaphore, which
+    // is the only thing telling us when the server is done with a frame
+    if (bPolicyDrawUP && !presentSemaphoreEnabled) {
+      bridge_util::Logger::warn("SharedHeap DrawUP policy requires presentSemaphoreEnabled, disabling it.");
+      sharedHeapPolicy &= ~SharedHeapPolicy::DrawUP;
+      bPolicyDrawUP = false;
+    }
     
     if(bridge_util::Config::isOptionDefined("useShadowMemoryForDynamicBuffers")) {
       const bool bUseShadowMemoryForDynamicBuffers =
@@ -79,7 +90,10 @@ void GlobalOptions::initSharedHeapPolicy() {
         policySS << "DYNAMIC BUFFERS, ";
       }
       if(bPolicyStaticBufs) {
-        policySS << "STATIC BUFFERS";
+        policySS << "STATIC BUFFERS, ";
+      }
+      if(bPolicyDrawUP) {
+        policySS << "DRAW UP";
       }
     }
 
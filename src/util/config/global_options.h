@@ -34,11 +34,12 @@ class GlobalOptions {
     Textures       = 1<<0,
     DynamicBuffers = 1<<1,
     StaticBuffers  = 1<<2,
+    DrawUP         = 1<<3,
 
     BuffersOnly    = DynamicBuffers | StaticBuffers,
 
     None           = 0,
-    All            = Textures | DynamicBuffers | StaticBuffers,
+    All            = Textures | DynamicBuffers | StaticBuffers | DrawUP,
   };
 
 public:
@@ -204,6 +205,14 @@ public:
     return (get().sharedHeapPolicy & SharedHeapPolicy::StaticBuffers) != 0;
   }
 
+  static bool getUseSharedHeapForDrawUP() {
+    return (get().sharedHeapPolicy & SharedHeapPolicy::DrawUP) != 0;
+  }
+
+  static const uint32_t getSharedHeapDrawUPFrameSize() {
+    return get().sharedHeapDrawUPFrameSize;
+  }
+
   static const uint32_t getSharedHeapDefaultSegmentSize() {
     return get().sharedHeapDefaultSegmentSize;
   }
@@ -253,6 +262,18 @@ public:
     return get().eliminateRedundantSetterCalls;
   }
 
+  static bool getCacheDeviceStatus() {
+    return get().cacheDeviceStatus;
+  }
+
+  static bool getFrameTimeline() {
+    return get().frameTimeline;
+  }
+
+  static uint32_t getFrameTimelineLogInterval() {
+    return get().frameTimelineLogInterval;
+  }
+
 private:
   GlobalOptions() = default;
 
@@ -415,6 +436,11 @@ private:
     static constexpr uint32_t kDefaultSharedHeapChunkSize = 4 << 10; // 4kB
     sharedHeapChunkSize = bridge_util::Config::getOption<uint32_t>("sharedHeapChunkSize", kDefaultSharedHeapChunkSize);
 
+    // Size of each per-frame linear allocation in the shared heap that DrawPrimitiveUP and
+    // DrawIndexedPrimitiveUP data is placed into when the DrawUP shared heap policy is active
+    static constexpr uint32_t kDefaultSharedHeapDrawUPFrameSize = 4 << 20; // 4MB
+    sharedHeapDrawUPFrameSize = bridge_util::Config::getOption<uint32_t>("sharedHeapDrawUPFrameSize", kDefaultSharedHeapDrawUPFrameSize);
+
     // The number of seconds to wait for a avaliable chunk to free up in the shared heap
     sharedHeapFreeChunkWaitTimeout = bridge_util::Config::getOption<uint32_t>("sharedHeapFreeChunkWaitTimeout", 10);
 
@@ -430,6 +456,17 @@ private:
     // If set, the bridge client will not send certain setter calls to the bridge server if the client knows the setter is writing
     // the the same value that is currently stored.
     eliminateRedundantSetterCalls = bridge_util::Config::getOption<bool>("eliminateRedundantSetterCalls", false);
+
+    // If set, the server publishes slowly changing device facts (e.g. available texture memory and the
+    // display mode) into shared memory on every Present, and the client answers queries for them without
+    // a round trip.
+    cacheDeviceStatus = bridge_util::Config::getOption<bool>("cacheDeviceStatus", true);
+
+    // If set, the client and the server timestamp the key points of each frame into shared memory, and the
+    // server plots the resulting latency breakdown in Tracy and logs statistics of it every given number of
+    // frames, if non-zero.
+    frameTimeline = bridge_util::Config::getOption<bool>("frameTimeline", true);
+    frameTimelineLogInterval = bridge_util::Config::getOption<uint32_t>("frameTimelineLogInterval", 0);
   }
 
   void initSharedHeapPolicy();
@@ -476,10 +513,14 @@ private:
   uint32_t sharedHeapPolicy;
   uint32_t sharedHeapSize;
   uint32_t sharedHeapDefaultSegmentSize;
+  uint32_t sharedHeapDrawUPFrameSize;
   uint32_t sharedHeapChunkSize;
   uint32_t sharedHeapFreeChunkWaitTimeout;
   uint32_t threadSafetyPolicy;
   bool alwaysCopyEntireStaticBuffer;
   bool exposeRemixApi;
   bool eliminateRedundantSetterCalls;
+  bool cacheDeviceStatus;
+  bool frameTimeline;
+  uint32_t frameTimelineLogInterval;
 };
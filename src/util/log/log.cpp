@@ -159,7 +159,9 @@ namespace bridge_util {
   }
 
   void Logger::logLine(const LogLevel level, const char* line) {
-    get().emitLine(level, line);
+    if (logger) {
+      logger->emitLine(level, line);
+    }
   }
 
   void Logger::emitMsg(const LogLevel level, const std::string& message) {
@@ -172,16 +174,16 @@ namespace bridge_util {
       std::scoped_lock lock(s_mutex);
       std::string line;
       while (std::getline(ss, line, '\n')) {
-        logger->emitLine(level, line);
+        logger->emitLine(level, line.c_str());
       }
     }
   }
 
-  void Logger::emitLine(const LogLevel level, const std::string& line) {
+  void Logger::emitLine(const LogLevel level, const char* line) {
     if (level >= m_level) {
 #ifdef REMIX_BRIDGE_CLIENT
       static char c_line[4096];
-      int len = sprintf_s(c_line, "%s\n", line.c_str());
+      int len = sprintf_s(c_line, "%s\n", line);
 #ifdef _DEBUG
       OutputDebugStringA(c_line);
 #endif
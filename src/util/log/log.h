@@ -61,6 +61,7 @@ namespace bridge_util {
     static void errLogMessageBoxAndExit(const std::string& message);
     static void log(const LogLevel level, const std::string& message);
     // The lowest level method. NOT thread-safe. Use at your own risk!
+    // Neither allocates nor locks, so it may be used from crash handlers.
     static void logLine(const LogLevel level, const char* line);
 
     static void set_loglevel(const LogLevel level);
@@ -85,7 +86,7 @@ namespace bridge_util {
 #endif
     static void emitPreInitMsgs();
     static void emitMsg(const LogLevel level, const std::string& message);
-    void emitLine(const LogLevel level, const std::string& line);
+    void emitLine(const LogLevel level, const char* line);
     static std::stringstream formatMessage(const LogLevel level, const std::string& message);
   };
 
@@ -22,9 +22,11 @@
 #pragma once
 
 #include "util_common.h"
+#include "util_validation.h"
 
 #include "../tracy/tracy.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <atomic>
 #include <assert.h>
@@ -37,6 +39,14 @@ namespace bridge_util {
   // Intra/Inter-process thread safe, shared circular queue.
   // Constructed from a shared pool of memory - and synchronized using static atomics
   // Single Producer, Single Consumer ONLY!
+  //
+  // Note: m_read is the position the producer writes the next element to and
+  // m_write is the position the consumer reads the next element from. Each
+  // side keeps a private copy of its own position and a cached copy of the
+  // other side's, and only touches the shared index of the other side when
+  // the cached one says the queue is full (producer) or empty (consumer).
+  // The consumer additionally publishes its position in batches, which keeps
+  // the cache line holding it from bouncing between processes on every pull.
   template<typename T, bridge_util::Accessor Accessor>
   class AtomicCircularQueue {
     std::atomic<uint32_t>* m_write;
@@ -46,6 +56,18 @@ namespace bridge_util {
     T m_default;
 
     const size_t m_queueSize;
+    const uint32_t m_consumerPublishBatch;
+
+    // Producer side
+    uint32_t m_producerPos = 0;
+    uint32_t m_cachedConsumerPos = 0;
+
+    // Consumer side
+    uint32_t m_consumerPos = 0;
+    mutable uint32_t m_numUnpublished = 0;
+    mutable uint32_t m_cachedProducerPos = 0;
+
+    static constexpr uint32_t kMaxConsumerPublishBatch = 32;
 
     static const size_t kAlignment = 128;
     static const size_t kWriteAtomicOffset = 0;
@@ -59,6 +81,7 @@ namespace bridge_util {
 
     AtomicCircularQueue(const std::string& name, void* pMemory, const size_t memSize, const size_t queueSize)
       : m_queueSize(queueSize)
+      , m_consumerPublishBatch(std::clamp<uint32_t>((uint32_t) queueSize / 8, 1, kMaxConsumerPublishBatch))
       , m_data(nullptr) // INIT
     {
       // Ensure we have enough memory
@@ -77,6 +100,11 @@ namespace bridge_util {
       }
 
       assert(m_read->is_lock_free() && m_write->is_lock_free()); // Must be runtime check as it's CPU specific
+
+      m_producerPos = m_read->load(std::memory_order_relaxed);
+      m_cachedConsumerPos = m_write->load(std::memory_order_acquire);
+      m_consumerPos = m_cachedConsumerPos;
+      m_cachedProducerPos = m_producerPos;
     }
 
     AtomicCircularQueue(const AtomicCircularQueue& q) = delete;
@@ -86,16 +114,22 @@ namespace bridge_util {
 
     // Push object to queue
     Result push(const T& obj) {
+      const auto currentRead = m_producerPos;
+      BRIDGE_VALIDATE_FULL(currentRead < m_queueSize);
+      const auto nextRead = queueIdxInc(currentRead);
       ULONGLONG start = 0, curTick;
       do {
-        const auto currentRead = m_read->load(std::memory_order_relaxed);
-        const auto nextRead = queueIdxInc(currentRead);
-        if (nextRead != m_write->load(std::memory_order_acquire)) {
+        // Only look at the consumer's index when the cached one says the
+        // queue is full. Acquire pairs with the consumer's release so its
+        // reads of the slot are done before the slot is overwritten.
+        if (nextRead == m_cachedConsumerPos) {
+          m_cachedConsumerPos = m_write->load(std::memory_order_acquire);
+        }
+        if (nextRead != m_cachedConsumerPos) {
           m_data[currentRead] = obj;
-          // The store above is not atomic. Issue a membar after it to ensure
-          // it is not reordered.
-          std::atomic_thread_fence(std::memory_order_seq_cst);
+          // Release orders the non-atomic store above before the index update
           m_read->store(nextRead, std::memory_order_release);
+          m_producerPos = nextRead;
           return Result::Success;
         }
 
@@ -116,12 +150,10 @@ namespace bridge_util {
     // Returns a ref to the first element in the queue
     // Note: Blocks if the queue is empty
     const T& peek(Result& result, const DWORD timeoutMS = 0) const {
+      const auto currentWrite = m_consumerPos;
       ULONGLONG start = 0, curTick;
       do {
-        const auto currentWrite = m_write->load(std::memory_order_relaxed);
-        if (currentWrite != m_read->load(std::memory_order_acquire)) {
-          // Issue a membar before reading the data since it is not atomic
-          std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (hasPending(currentWrite)) {
           result = Result::Success;
           return m_data[currentWrite];
         }
@@ -140,13 +172,19 @@ namespace bridge_util {
     // Returns a copy to the first element in queue, AND removes it
     // Note: Blocks if queue is empty
     const T& pull(Result& result, const DWORD timeoutMS = 0) {
+      const auto currentWrite = m_consumerPos;
+      BRIDGE_VALIDATE_FULL(currentWrite < m_queueSize);
       ULONGLONG start = 0, curTick;
       do {
-        const auto currentWrite = m_write->load(std::memory_order_relaxed);
-        if (currentWrite != m_read->load(std::memory_order_acquire)) {
-          m_write->store(queueIdxInc(currentWrite), std::memory_order_release);
-          // Issue a membar before reading the data since it is not atomic
-          std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (hasPending(currentWrite)) {
+          m_consumerPos = queueIdxInc(currentWrite);
+          // Release the slots consumed before this one in batches. The slot
+          // returned here stays owned by the consumer until the next publish,
+          // so the caller's reference cannot be overwritten underneath it.
+          if (++m_numUnpublished >= m_consumerPublishBatch) {
+            m_write->store(currentWrite, std::memory_order_release);
+            m_numUnpublished = 1;
+          }
           result = Result::Success;
           return m_data[currentWrite];
         }
@@ -160,12 +198,38 @@ namespace bridge_util {
       return m_default;
     }
 
+    // Returns the element the given number of positions past the next one to
+    // be pulled, or nullptr if the producer has not pushed that far yet.
+    // Never blocks, meant for lookahead by the consumer.
+    const T* peekAhead(const uint32_t ahead) const {
+      if (ahead >= m_queueSize - 1) {
+        return nullptr;
+      }
+      auto available = [&]() {
+        return m_cachedProducerPos >= m_consumerPos ?
+          m_cachedProducerPos - m_consumerPos :
+          m_cachedProducerPos + (uint32_t) m_queueSize - m_consumerPos;
+      };
+      if (ahead >= available()) {
+        m_cachedProducerPos = m_read->load(std::memory_order_acquire);
+        if (ahead >= available()) {
+          return nullptr;
+        }
+      }
+      const uint32_t idx = m_consumerPos + ahead;
+      return &m_data[idx < m_queueSize ? idx : idx - m_queueSize];
+    }
+
     // Check for queue emptiness. The function may guarantee a correct result
     // ONLY when the queue is stalled on either end and only a single index
     // is advancing.
     bool isEmpty() const {
-      const auto currentWrite = m_write->load(std::memory_order_relaxed);
-      return currentWrite == m_read->load(std::memory_order_acquire);
+      if constexpr (IS_READER(Accessor)) {
+        return !hasPending(m_consumerPos);
+      } else {
+        const auto currentWrite = m_write->load(std::memory_order_relaxed);
+        return currentWrite == m_read->load(std::memory_order_acquire);
+      }
     }
 
     std::vector<Commands::D3D9Command> buildQueueData(int maxQueueElements, int currentIndex) {
@@ -194,6 +258,27 @@ namespace bridge_util {
       return buildQueueData(maxQueueElements, currentIndex);
     }
 
+    // Consumer side: checks whether the element at currentWrite is available.
+    // The producer's index is only loaded when the cached one runs dry, and
+    // when the queue is found empty the consumer position is published in
+    // full, so a producer waiting on a full queue is never left stalled.
+    bool hasPending(const uint32_t currentWrite) const {
+      if (currentWrite != m_cachedProducerPos) {
+        return true;
+      }
+      // Acquire pairs with the producer's release so the slot contents are
+      // visible once the new index is
+      m_cachedProducerPos = m_read->load(std::memory_order_acquire);
+      if (currentWrite != m_cachedProducerPos) {
+        return true;
+      }
+      if (m_numUnpublished > 0) {
+        m_write->store(currentWrite, std::memory_order_release);
+        m_numUnpublished = 0;
+      }
+      return false;
+    }
+
     uint32_t queueIdxInc(uint32_t idx) const {
       return idx + 1 < m_queueSize ? idx + 1 : 0;
     }
@@ -88,6 +88,11 @@ namespace bridge_util {
       return result;
     }
 
+    // Lookahead is not supported by the semaphore based queue
+    const T* peekAhead(const uint32_t ahead) const {
+      return nullptr;
+    }
+
     // Returns a ref to the first element in the queue
     // Note: Blocks if the queue is empty
     const T& peek(Result& result, const DWORD timeoutMS = 0) {
@@ -20,6 +20,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 #include "util_bridgecommand.h"
+#include "util_commandhistory.h"
+#include "util_frametimeline.h"
 #include "log/log_strings.h"
 
 namespace {
@@ -56,11 +58,37 @@ DECL_BRIDGE_FUNC(void, init,
 }
 
 DECL_BRIDGE_FUNC(void, syncDataQueue, size_t expectedMemUsage, bool posResetOnLastIndex) {
-  int serverCount = *s_pWriterChannel->serverDataPos;
   size_t currClientDataPos = s_pWriterChannel->get_data_pos();
   size_t expectedClientDataPos = currClientDataPos + ((expectedMemUsage != 0) ? expectedMemUsage : 1) - 1;
   size_t totalSize = s_pWriterChannel->data->get_total_size();
 
+  accumulate_written();
+
+  // Fast path: the reader can only have advanced since the last refresh, so
+  // if the worst case estimate of unread data still leaves a comfortable
+  // margin there is no need to look at the shared reader position at all.
+  const bool wrapsAround = expectedClientDataPos >= totalSize;
+  if (s_unreadAtReaderPosRefresh >= 0 && !(wrapsAround && *s_pWriterChannel->serverResetPosRequired)) {
+    const size_t requiredSpace = expectedMemUsage + 1 +
+      ((wrapsAround && posResetOnLastIndex) ? totalSize - currClientDataPos : 0);
+    const size_t margin = totalSize / 16;
+    const uint64_t unreadEstimate =
+      (uint64_t) s_unreadAtReaderPosRefresh + (s_totalWritten - s_totalWrittenAtReaderPosRefresh);
+    if (unreadEstimate + requiredSpace + margin < totalSize) {
+      if (wrapsAround) {
+        *s_pWriterChannel->serverResetPosRequired = true;
+      }
+      return;
+    }
+  }
+
+  int serverCount = (int) *s_pWriterChannel->serverDataPos;
+  s_unreadAtReaderPosRefresh = (serverCount < 0) ? -1 :
+    (currClientDataPos >= (size_t) serverCount) ?
+      currClientDataPos - serverCount :
+      currClientDataPos + totalSize - serverCount;
+  s_totalWrittenAtReaderPosRefresh = s_totalWritten;
+
   auto handleOverwriteCondition = [&]() {
     // Below variable is set to let the server know that a particular position
     // in the queue not yet accessed by it is going to be used
@@ -115,6 +143,47 @@ DECL_BRIDGE_FUNC(void, syncDataQueue, size_t expectedMemUsage, bool posResetOnLa
   }
 }
 
+DECL_BRIDGE_FUNC(void, onPresentSent, uint32_t maxFramesInFlight) {
+  std::scoped_lock lock(s_pWriterChannel->m_mutex);
+  accumulate_written();
+  const size_t numFrames = maxFramesInFlight + 1 + s_numUnacknowledgedPresents;
+  if (s_totalWrittenAtPresent.size() != numFrames) {
+    // Zero is a valid, if pessimistic, bound for Presents not sent yet
+    s_totalWrittenAtPresent.assign(numFrames, 0);
+    s_curPresent = 0;
+  }
+  s_curPresent = (s_curPresent + 1) % s_totalWrittenAtPresent.size();
+  s_totalWrittenAtPresent[s_curPresent] = s_totalWritten;
+}
+
+DECL_BRIDGE_FUNC(void, onPresentAcknowledged) {
+  std::scoped_lock lock(s_pWriterChannel->m_mutex);
+  if (s_totalWrittenAtPresent.empty()) {
+    return;
+  }
+  accumulate_written();
+  // The Present maxFramesInFlight frames back lives in the next slot
+  const uint64_t consumed = s_totalWrittenAtPresent[(s_curPresent + 1) % s_totalWrittenAtPresent.size()];
+  const uint64_t unread = s_totalWritten - consumed;
+  // Frames larger than the queue can't be bounded this way, those fall back
+  // to the shared reader position in syncDataQueue()
+  if (unread >= s_pWriterChannel->data->get_total_size()) {
+    return;
+  }
+  const bool bTighter = s_unreadAtReaderPosRefresh < 0 ||
+    unread < (uint64_t) s_unreadAtReaderPosRefresh + (s_totalWritten - s_totalWrittenAtReaderPosRefresh);
+  if (bTighter) {
+    s_unreadAtReaderPosRefresh = (int64_t) unread;
+    s_totalWrittenAtReaderPosRefresh = s_totalWritten;
+  }
+}
+
+DECL_BRIDGE_FUNC(void, onPresentUnacknowledged) {
+  std::scoped_lock lock(s_pWriterChannel->m_mutex);
+  // The next onPresentSent() grows the ring by a frame and starts it over
+  ++s_numUnacknowledgedPresents;
+}
+
 DECL_BRIDGE_FUNC(Header, pop_front) {
   ZoneScoped;
   Result result;
@@ -259,6 +328,12 @@ DECL_COMMAND_FUNC(,Command,const Commands::D3D9Command command,
   : m_command(command)
   , m_handle((uint32_t) (size_t) pHandle)
   , m_commandFlags(commandFlags) {
+#ifdef REMIX_BRIDGE_CLIENT
+  if (s_pfnFlushHeldCommands) {
+    s_pfnFlushHeldCommands();
+  }
+#endif
+
   // If the assert or exception gets triggered it means that there is more than one Command
   // instance in a function or command block with overlapping object lifecycles. Only one instance
   // can be alive at a time to ensure data integrity on the command and data buffers. To resolve
@@ -277,6 +352,9 @@ DECL_COMMAND_FUNC(,Command,const Commands::D3D9Command command,
 
 #ifdef REMIX_BRIDGE_CLIENT
   s_pWriterChannel->m_mutex.lock();
+  if constexpr (std::is_same_v<BridgeId, ::BridgeId::Device>) {
+    FrameTimeline::onClientCommand();
+  }
 #endif
 
   assert(!s_pWriterChannel->pbCmdInProgress->load());
@@ -311,6 +389,10 @@ DECL_COMMAND_FUNC(,Command,const Commands::D3D9Command command,
 DECL_COMMAND_FUNC(,~Command) {
   // Only actually send the command if the bridge is enabled, otherwise this becomes a no-op
   if (gbBridgeRunning) {
+    const size_t dataEndPos = s_pWriterChannel->data->get_pos();
+    const size_t dataUsed = (dataEndPos >= (size_t) s_curBatchStartPos) ?
+      dataEndPos - s_curBatchStartPos :
+      dataEndPos + s_pWriterChannel->data->get_total_size() - s_curBatchStartPos;
     s_pWriterChannel->data->end_batch();
     s_curBatchStartPos = -1;
     uint32_t numRetries = 0;
@@ -341,10 +423,20 @@ DECL_COMMAND_FUNC(,~Command) {
       if (RESULT_FAILURE(result) && gbBridgeRunning) {
         Logger::err(format_string("The command %s could not be successfully sent, turning bridge off and falling back to client rendering!", Commands::toString(m_command).c_str()));
         gbBridgeRunning = false;
+        CommandHistory::dump();
       } else if (RESULT_SUCCESS(result) && numRetries > 1) {
         std::string command = Commands::toString(m_command);
         Logger::debug(format_string("The command %s took %d retries (%d ms)!", command.c_str(), numRetries, numRetries * GlobalOptions::getCommandTimeout()));
       }
+    if (RESULT_SUCCESS(result)) {
+#ifdef REMIX_BRIDGE_CLIENT
+      const uint32_t uid = (uint32_t) s_cmdUID;
+#else
+      const uint32_t uid = m_handle;
+#endif
+      CommandHistory::record(kHistoryTag, CommandHistory::Direction::Sent, m_command, uid,
+                             (uint32_t) (dataUsed * sizeof(DataT)));
+    }
   }
   s_pWriterChannel->pbCmdInProgress->store(false);
 #ifdef REMIX_BRIDGE_CLIENT
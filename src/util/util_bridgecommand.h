@@ -29,8 +29,12 @@
 #include "util_bridge_state.h"
 #include "util_ipcchannel.h"
 #include "util_singleton.h"
+#include "util_validation.h"
 #include "../tracy/tracy.hpp"
 
+#include <vector>
+#include <xmmintrin.h>
+
 extern bool gbBridgeRunning;
 
 #define WAIT_FOR_SERVER_RESPONSE(func, value, uidVal) \
@@ -156,10 +160,7 @@ public:
     const DataT& retval = getReaderChannel().data->pull_and_copy(obj);
 
     if (checkSize) {
-      assert((size_t) retval == sizeof(T) && "Size of source and target object does not match!");
-      if ((size_t) retval != sizeof(T)) {
-        Logger::err("DataQueue copy data: Size of source and target object does not match!");
-      }
+      BRIDGE_VALIDATE_CHEAP((size_t) retval == sizeof(T));
     }
 
     // Check if the server completed a loop
@@ -174,6 +175,44 @@ public:
     return getReaderChannel().data->get_pos();
   }
 
+  // Size in bytes of the data a command ending at the given data offset has yet to consume
+  static inline uint32_t get_pending_data_size(const uint32_t dataOffset) {
+    const size_t dataPos = get_data_pos();
+    const size_t numItems = (dataOffset >= dataPos) ?
+      dataOffset - dataPos :
+      dataOffset + getReaderChannel().data->get_total_size() - dataPos;
+    return (uint32_t) (numItems * sizeof(DataT));
+  }
+
+  // Prefetches the data of up to lookahead commands queued behind the given,
+  // just pulled, one so it is already in cache by the time they execute.
+  // Commands prefetched by an earlier call are not prefetched again.
+  static inline void prefetch_ahead(const Header& current, const uint32_t lookahead) {
+    ZoneScoped;
+    const auto& commands = *getReaderChannel().commands;
+    if (s_numPrefetchedAhead > 0) {
+      --s_numPrefetchedAhead;
+    }
+    uint32_t dataBegin = current.dataOffset;
+    if (s_numPrefetchedAhead > 0) {
+      const Header* const pLastPrefetched = commands.peekAhead(s_numPrefetchedAhead - 1);
+      if (pLastPrefetched) {
+        dataBegin = pLastPrefetched->dataOffset;
+      } else {
+        s_numPrefetchedAhead = 0;
+      }
+    }
+    for (uint32_t i = s_numPrefetchedAhead; i < lookahead; ++i) {
+      const Header* const pNext = commands.peekAhead(i);
+      if (!pNext) {
+        break;
+      }
+      prefetch_data(dataBegin, pNext->dataOffset);
+      dataBegin = pNext->dataOffset;
+      ++s_numPrefetchedAhead;
+    }
+  }
+
   static inline bridge_util::Result begin_read_data() {
     ZoneScoped;
     if (gbBridgeRunning) {
@@ -192,6 +231,25 @@ public:
 
   static Header pop_front();
   static void syncDataQueue(size_t expectedMemUsage, bool posResetOnLastIndex = false);
+  // Frame scoped reclamation of the data queue when syncing on Present: once
+  // the Present semaphore has been acquired the reader is known to have
+  // consumed everything written up to the Present maxFramesInFlight frames
+  // back, so the local view of free space is refreshed without looking at
+  // the shared reader position.
+  static void onPresentSent(uint32_t maxFramesInFlight);
+  static void onPresentAcknowledged();
+  // A Present whose semaphore wait failed leaves the semaphore one release
+  // ahead for good, so every later acquire acknowledges a frame further back.
+  static void onPresentUnacknowledged();
+#ifdef REMIX_BRIDGE_CLIENT
+  // Commands the client holds back to send later in bulk, like batched draws, must be
+  // sent ahead of any other command to keep their order. The registered callback is run
+  // whenever a command is started and may send commands itself.
+  using FlushHeldCommandsFn = void(*)();
+  static void setFlushHeldCommands(FlushHeldCommandsFn pfnFlush) {
+    s_pfnFlushHeldCommands = pfnFlush;
+  }
+#endif
   static bridge_util::Result ensureQueueEmpty();
 
   //=========================//
@@ -267,6 +325,22 @@ public:
       }
     }
 
+    // Sends a mixed list of scalars and DataBlobs, reserving queue space for
+    // all of them at once rather than per item
+    template<typename... Ts>
+    inline void send_vectored(const Ts&... objs) {
+      ZoneScoped;
+      if (gbBridgeRunning) {
+        const size_t memUsed = DataQueue::vectored_size(objs...);
+        syncDataQueue(memUsed, (is_data_blob_v<Ts> || ...));
+        const auto result = s_pWriterChannel->data->push_vectored(memUsed, objs...);
+        if (RESULT_FAILURE(result)) {
+          // For now just log when things go wrong, but could use some robustness improvements
+          Logger::err("DataQueue send_vectored: Failed to send multiple data items!");
+        }
+      }
+    }
+
     inline uint8_t* begin_data_blob(const size_t size) {
       ZoneScoped;
       uint8_t* blobPacketPtr = nullptr;
@@ -337,12 +411,60 @@ private:
   Bridge() = delete;
   Bridge(const Bridge&) = delete;
   Bridge(const Bridge&&) = delete;
+
+  // Only the first few cache lines of a command's data are prefetched, large
+  // uploads are streamed through by memcpy anyway
+  static constexpr size_t kMaxPrefetchBytesPerCommand = 2048;
+  static constexpr size_t kCacheLineSize = 64;
+
+  static inline void prefetch_data(const uint32_t begin, const uint32_t end) {
+    const uint8_t* const pData = (const uint8_t*) getReaderChannel().get_data_ptr();
+    const size_t totalBytes = getReaderChannel().data->get_total_size() * sizeof(DataT);
+    const size_t offset = begin * sizeof(DataT);
+    size_t size = ((end >= begin) ? end - begin : end + totalBytes / sizeof(DataT) - begin) * sizeof(DataT);
+    size = std::min(size, kMaxPrefetchBytesPerCommand);
+    for (size_t i = 0; i < size; i += kCacheLineSize) {
+      const size_t pos = offset + i;
+      _mm_prefetch((const char*) pData + (pos < totalBytes ? pos : pos - totalBytes), _MM_HINT_T0);
+    }
+  }
+
   static inline WriterChannel* s_pWriterChannel = nullptr;
   static inline ReaderChannel* s_pReaderChannel = nullptr;
   static inline int32_t        s_curBatchStartPos = -1;
+  static inline uint32_t       s_numPrefetchedAhead = 0;
+#ifdef REMIX_BRIDGE_CLIENT
+  static inline FlushHeldCommandsFn s_pfnFlushHeldCommands = nullptr;
+#endif
+  // Conservative local view of the reader's data position: the amount of
+  // unread data when the reader position was last learned, plus everything
+  // written since. It is refreshed for free whenever a Present is
+  // acknowledged, and from shared memory only when space looks tight.
+  static inline int64_t        s_unreadAtReaderPosRefresh = -1;
+  static inline uint64_t       s_totalWrittenAtReaderPosRefresh = 0;
+  // Running total of data written to the queue, in queue elements
+  static inline uint64_t       s_totalWritten = 0;
+  static inline size_t         s_lastSyncDataPos = 0;
+  // s_totalWritten right after each of the Presents that may be in flight
+  static inline std::vector<uint64_t> s_totalWrittenAtPresent;
+  static inline size_t         s_curPresent = 0;
+  // Present semaphore waits that failed, each one adds a frame in flight
+  static inline uint32_t       s_numUnacknowledgedPresents = 0;
+
+  static inline void accumulate_written() {
+    // Every sync covers less than a full lap of the queue, so the distance
+    // between consecutive positions is the amount of data written in between
+    const size_t currPos = s_pWriterChannel->get_data_pos();
+    s_totalWritten += (currPos >= s_lastSyncDataPos) ?
+      currPos - s_lastSyncDataPos :
+      currPos + s_pWriterChannel->data->get_total_size() - s_lastSyncDataPos;
+    s_lastSyncDataPos = currPos;
+  }
   static inline size_t         s_cmdCounter = 0;
   // UIDs are assigned to commands to tag the responses from server to allow misorder responses to be handled correctly 
   static inline UID s_cmdUID = 0;
+  // Tag identifying this bridge in the command history
+  static constexpr char kHistoryTag = std::is_same_v<BridgeId, ::BridgeId::Device> ? 'D' : 'M';
 #if defined(REMIX_BRIDGE_CLIENT)
   static constexpr char kWriterChannelName[] = "Client2Server";
   static constexpr char kReaderChannelName[] = "Server2Client";
@@ -25,6 +25,7 @@
 #include <cstdio>
 #include <mutex>
 #include <string>
+#include <type_traits>
 
 #include "util_circularqueue.h"
 #include "log/log_strings.h"
@@ -32,6 +33,16 @@
 
 namespace bridge_util {
 
+  // Sized object for CircularBuffer::push_vectored(), laid out in the queue
+  // exactly like push(size, obj) lays it out
+  struct DataBlob {
+    size_t size;
+    const void* obj;
+  };
+
+  template<typename V>
+  inline constexpr bool is_data_blob_v = std::is_same_v<std::decay_t<V>, DataBlob>;
+
   template<typename T>
   class CircularBuffer: public CircularQueue<T> {
   public:
@@ -89,10 +100,44 @@ namespace bridge_util {
       return Result::Failure;
     }
 
+    // Number of queue elements push_vectored() takes for the given items.
+    // Lists of scalars only are sized at compile time.
+    template<typename... Ts>
+    static constexpr size_t vectored_size(const Ts&... items) {
+      if constexpr ((is_data_blob_v<Ts> || ...)) {
+        return (item_size(items) + ... + 0);
+      } else {
+        return sizeof...(Ts);
+      }
+    }
+
+    // Pushes a mixed list of scalars and DataBlobs with a single space check
+    // and straight copies. The items end up laid out as if they had been
+    // pushed one at a time, so the reader pulls them as usual.
+    template<typename... Ts>
+    Result push_vectored(const size_t totalSize, const Ts&... items) {
+      // Using < so that a list ending right at the end of the queue still
+      // gets its rollover done by the individual pushes below
+      if (m_pos + totalSize < m_size) {
+        T* pDst = m_data + m_pos;
+        (write_item(pDst, items), ...);
+        m_pos += totalSize;
+        if (m_batchInProgress) {
+          m_batchSize += sizeof...(Ts);
+        }
+      } else {
+        // Blobs never wrap around but roll over to the start of the queue,
+        // which the individual pushes take care of
+        (push_item(items), ...);
+      }
+      return Result::Success;
+    }
+
     // Returns the size of the variable size object and sets the pointer
     // to the beginning of the object.
     const T& pull(void** obj) {
       const T& size = pull();
+      BRIDGE_VALIDATE_FULL(size <= m_size * sizeof(T));
 
       if (const size_t ensured_space = ensure_space(size)) {
         *obj = &m_data[m_pos];
@@ -154,6 +199,39 @@ namespace bridge_util {
     constexpr size_t chunk_size(const size_t size) const {
       return align(size, sizeof(T)) / sizeof(T);
     }
+
+    template<typename V>
+    static constexpr size_t item_size(const V&) {
+      return 1;
+    }
+
+    static constexpr size_t item_size(const DataBlob& blob) {
+      return blob.obj ? 1 + align(blob.size, sizeof(T)) / sizeof(T) : 1;
+    }
+
+    template<typename V>
+    FORCEINLINE static void write_item(T*& pDst, const V& obj) {
+      *pDst++ = static_cast<T>(obj);
+    }
+
+    FORCEINLINE static void write_item(T*& pDst, const DataBlob& blob) {
+      if (blob.obj) {
+        *pDst++ = static_cast<T>(blob.size);
+        memcpy(pDst, blob.obj, blob.size);
+        pDst += align(blob.size, sizeof(T)) / sizeof(T);
+      } else {
+        *pDst++ = 0;
+      }
+    }
+
+    template<typename V>
+    void push_item(const V& obj) {
+      push(static_cast<T>(obj));
+    }
+
+    void push_item(const DataBlob& blob) {
+      push(blob.size, blob.obj);
+    }
   };
 
   typedef CircularBuffer<uint32_t> DataQueue;
@@ -26,6 +26,7 @@
 #include <type_traits>
 
 #include "util_common.h"
+#include "util_validation.h"
 
 namespace bridge_util {
 
@@ -109,6 +110,7 @@ namespace bridge_util {
     // Returns a ref to the first element in the queue
     // Note: May be stale data!
     const T& peek() {
+      BRIDGE_VALIDATE_FULL(m_pos < m_size);
       const T& data = m_data[m_pos];
       return data;
     }
@@ -121,6 +123,7 @@ namespace bridge_util {
 
     // Returns a copy to the first element in queue, AND removes it
     const T& pull() {
+      BRIDGE_VALIDATE_FULL(m_pos < m_size);
       const T& retval = m_data[m_pos];
       pop();
       return retval;
@@ -160,6 +163,7 @@ namespace bridge_util {
       if (BatchInProgress) {
         m_batchSize++;
       }
+      BRIDGE_VALIDATE_FULL(m_pos < m_size);
       m_data[m_pos] = obj;
       return pop();
     }
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "util_commandhistory.h"
+#include "log/log.h"
+
+#include <algorithm>
+#include <stdio.h>
+
+namespace bridge_util {
+
+  CommandHistory::Ring CommandHistory::s_rings[kMaxThreads];
+
+  CommandHistory::Ring* CommandHistory::registerThread() {
+    // Prefer rings that were never written to, so that the history of exited
+    // threads survives for as long as possible
+    for (const bool bRecycle : { false, true }) {
+      for (Ring& ring : s_rings) {
+        if (!bRecycle && ring.pos.load(std::memory_order_relaxed) > 0) {
+          continue;
+        }
+        bool inUse = false;
+        if (ring.inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire)) {
+          ring.pos.store(0, std::memory_order_relaxed);
+          ring.threadId = GetCurrentThreadId();
+          return &ring;
+        }
+      }
+    }
+    // Out of rings, commands on this thread will go unrecorded
+    return nullptr;
+  }
+
+  void CommandHistory::dump() {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+
+    // Find the most recent timestamp across all threads to have a common reference point
+    uint64_t newest = 0;
+    for (const Ring& ring : s_rings) {
+      const uint32_t pos = ring.pos.load(std::memory_order_acquire);
+      if (pos > 0) {
+        newest = std::max(newest, ring.entries[(pos - 1) % kEntriesPerThread].timestamp);
+      }
+    }
+
+    // Formatted on the stack, the heap may be what brought us here
+    char line[256];
+    for (const Ring& ring : s_rings) {
+      const uint32_t pos = ring.pos.load(std::memory_order_acquire);
+      if (pos == 0) {
+        continue;
+      }
+      const uint32_t numEntries = std::min<uint32_t>(pos, kEntriesPerThread);
+      sprintf_s(line, "Command history of thread %lu%s (%u of %u commands):",
+                ring.threadId,
+                ring.inUse.load(std::memory_order_relaxed) ? "" : ", exited",
+                numEntries, pos);
+      Logger::logLine(LogLevel::Info, line);
+      for (uint32_t i = pos - numEntries; i < pos; ++i) {
+        const Entry& entry = ring.entries[i % kEntriesPerThread];
+        const double usAgo = (double) (newest - entry.timestamp) * 1000000.0 / (double) frequency.QuadPart;
+        sprintf_s(line, "  -%12.1fus %c %s %s UID: %u, data: %u bytes",
+                  usAgo,
+                  entry.bridge,
+                  entry.direction == Direction::Sent ? "sent" : "recv",
+                  Commands::getName(entry.command),
+                  entry.uid,
+                  entry.dataSize);
+        Logger::logLine(LogLevel::Info, line);
+      }
+    }
+  }
+
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "util_commands.h"
+
+#include <windows.h>
+#include <atomic>
+#include <stdint.h>
+
+namespace bridge_util {
+
+  // Fixed-size, per-thread history of the most recent commands that went
+  // through the bridge, kept around purely for post-mortem diagnostics.
+  // Recording an entry is a handful of stores into a thread-local ring with
+  // no locking or allocation, so it is always enabled and can be dumped on a
+  // crash, timeout or exit without having turned on any trace logging.
+  // Dumping is best effort: it reads the rings of other threads while they
+  // may still be written to, which at worst yields a torn entry. It neither
+  // allocates nor locks, so it is safe to call from the exception filter.
+  // The rings of exited threads are kept for the dump until a new thread
+  // needs one and no never-used ring is left.
+  class CommandHistory {
+  public:
+    enum class Direction : uint8_t {
+      Sent,
+      Received
+    };
+
+    struct Entry {
+      uint64_t timestamp;           // QueryPerformanceCounter ticks
+      uint32_t uid;
+      uint32_t dataSize;            // Bytes of data queue memory used by the command
+      Commands::D3D9Command command;
+      Direction direction;
+      char bridge;                  // 'D'evice or 'M'odule bridge
+    };
+
+    static constexpr size_t kEntriesPerThread = 256;
+    static constexpr size_t kMaxThreads = 32;
+
+    static inline void record(const char bridge, const Direction direction,
+                              const Commands::D3D9Command command, const uint32_t uid,
+                              const uint32_t dataSize) {
+      Ring* const pRing = getThreadRing();
+      if (pRing == nullptr) {
+        return;
+      }
+      LARGE_INTEGER ticks;
+      QueryPerformanceCounter(&ticks);
+      const uint32_t pos = pRing->pos.load(std::memory_order_relaxed);
+      Entry& entry = pRing->entries[pos % kEntriesPerThread];
+      entry.timestamp = ticks.QuadPart;
+      entry.uid = uid;
+      entry.dataSize = dataSize;
+      entry.command = command;
+      entry.direction = direction;
+      entry.bridge = bridge;
+      pRing->pos.store(pos + 1, std::memory_order_release);
+    }
+
+    // Writes the history of every thread that has recorded commands to the log,
+    // oldest entry first, with timestamps relative to the most recent entry.
+    static void dump();
+
+  private:
+    struct Ring {
+      std::atomic<bool> inUse = false;
+      DWORD threadId = 0;
+      std::atomic<uint32_t> pos = 0;
+      Entry entries[kEntriesPerThread];
+    };
+
+    // Hands the ring back once its thread exits
+    struct RingLease {
+      Ring* const pRing = registerThread();
+      ~RingLease() {
+        if (pRing) {
+          pRing->inUse.store(false, std::memory_order_release);
+        }
+      }
+    };
+
+    static Ring* getThreadRing() {
+      thread_local RingLease lease;
+      return lease.pRing;
+    }
+    static Ring* registerThread();
+
+    static Ring s_rings[kMaxThreads];
+  };
+
+}
@@ -224,6 +224,9 @@ namespace Commands {
     IDirect3DDevice9Ex_CreateDepthStencilSurfaceEx,
     IDirect3DDevice9Ex_ResetEx,
     IDirect3DDevice9Ex_GetDisplayModeEx,
+    IDirect3DDevice9Ex_SetInputAssembly,
+    IDirect3DDevice9Ex_MultiDraw,
+    IDirect3DDevice9Ex_SetTransformsAndLights,
 
 
     IDirect3DStateBlock9_QueryInterface,
@@ -418,6 +421,7 @@ namespace Commands {
     IDirect3DSurface9_GetDesc,
     IDirect3DSurface9_LockRect,
     IDirect3DSurface9_UnlockRect,
+    IDirect3DSurface9_UnlockRects,
     IDirect3DSurface9_GetDC,
     IDirect3DSurface9_ReleaseDC,
 
@@ -465,7 +469,8 @@ namespace Commands {
     kIDirect3DQuery9 = IDirect3DQuery9_QueryInterface
   };
 
-  inline static std::string toString(const D3D9Command& command) {
+  // Returns a static string, usable where allocating is not an option
+  inline static const char* getName(const D3D9Command& command) {
     switch (command) {
     case Bridge_Terminate: return "Terminate";
     case Bridge_Invalid: return "Invalid";
@@ -655,6 +660,9 @@ namespace Commands {
     case IDirect3DDevice9Ex_CreateDepthStencilSurfaceEx: return "IDirect3DDevice9Ex_CreateDepthStencilSurfaceEx";
     case IDirect3DDevice9Ex_ResetEx: return "IDirect3DDevice9Ex_ResetEx";
     case IDirect3DDevice9Ex_GetDisplayModeEx: return "IDirect3DDevice9Ex_GetDisplayModeEx";
+    case IDirect3DDevice9Ex_SetInputAssembly: return "IDirect3DDevice9Ex_SetInputAssembly";
+    case IDirect3DDevice9Ex_MultiDraw: return "IDirect3DDevice9Ex_MultiDraw";
+    case IDirect3DDevice9Ex_SetTransformsAndLights: return "IDirect3DDevice9Ex_SetTransformsAndLights";
 
     case IDirect3DStateBlock9_QueryInterface: return "IDirect3DStateBlock9_QueryInterface";
     case IDirect3DStateBlock9_AddRef: return "IDirect3DStateBlock9_AddRef";
@@ -836,6 +844,7 @@ namespace Commands {
     case IDirect3DSurface9_GetDesc: return "IDirect3DSurface9_GetDesc";
     case IDirect3DSurface9_LockRect: return "IDirect3DSurface9_LockRect";
     case IDirect3DSurface9_UnlockRect: return "IDirect3DSurface9_UnlockRect";
+    case IDirect3DSurface9_UnlockRects: return "IDirect3DSurface9_UnlockRects";
     case IDirect3DSurface9_GetDC: return "IDirect3DSurface9_GetDC";
     case IDirect3DSurface9_ReleaseDC: return "IDirect3DSurface9_ReleaseDC";
 
@@ -864,6 +873,10 @@ namespace Commands {
     }
   }
 
+  inline static std::string toString(const D3D9Command& command) {
+    return getName(command);
+  }
+
   typedef uint16_t Flags;
 
   enum FlagBits: Flags {
@@ -871,6 +884,8 @@ namespace Commands {
                                     // and only allocation id(s) is transferred on the queue
     DataIsReserved   = 0b00000010,  // Data was already reserved in data queue and only its
                                     // offset is transferred
+    DataIsCompressed = 0b00000100,  // Upload payload on the data queue is compressed with
+                                    // bridge_util::Compression
   };
 
   inline bool IsDataInSharedHeap(Flags flags) {
@@ -880,6 +895,34 @@ namespace Commands {
   inline bool IsDataReserved(Flags flags) {
     return (flags & FlagBits::DataIsReserved) != 0;
   }
+
+  inline bool IsDataCompressed(Flags flags) {
+    return (flags & FlagBits::DataIsCompressed) != 0;
+  }
+
+  // Bindings carried by IDirect3DDevice9Ex_SetInputAssembly besides the stream sources
+  // and frequencies, which are flagged by their own per-stream masks
+  enum InputAssemblyBits: uint32_t {
+    IndicesChanged    = 0b00000001,
+    VertexDeclChanged = 0b00000010,
+    FVFChanged        = 0b00000100,
+  };
+
+  // Leading word of each draw packed into an IDirect3DDevice9Ex_MultiDraw command, followed
+  // by the input assembly bindings and the transforms and lights changed since the previous
+  // draw, if flagged, and then by the draw call arguments
+  enum MultiDrawBits: uint32_t {
+    MultiDrawPrimitive           = 0,
+    MultiDrawIndexedPrimitive    = 1,
+    MultiDrawOpMask              = 0x0000ffff,
+    MultiDrawInputAssembly       = 0x00010000,
+    MultiDrawTransformsAndLights = 0x00020000,
+  };
+
+  // Words describing each surface rect packed into an IDirect3DSurface9_UnlockRects command:
+  // surface handle, rect left, top, right and bottom, lock flags, format and row size. The
+  // rows of all rects follow tightly packed in a second blob, in the same order.
+  constexpr uint32_t kUnlockRectsWordsPerRect = 8;
 }
 
 struct Header {
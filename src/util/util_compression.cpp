@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "util_compression.h"
+
+#include <cstring>
+
+namespace bridge_util {
+  namespace Compression {
+    namespace {
+      constexpr size_t kMinMatch = 4;
+      // The format requires the last 5 bytes to be literals and the last
+      // match to start at least 12 bytes before the end of the input
+      constexpr size_t kLastLiterals = 5;
+      constexpr size_t kMatchFindLimit = 12;
+      constexpr size_t kMaxDistance = 0xFFFF;
+      constexpr uint32_t kHashLog = 12;
+      // Raise to probe less often over incompressible data
+      constexpr uint32_t kSkipTrigger = 6;
+
+      inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+      }
+
+      inline uint32_t hash(const uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - kHashLog);
+      }
+
+      inline uint8_t* writeLength(uint8_t* op, size_t length) {
+        while (length >= 255) {
+          *op++ = 255;
+          length -= 255;
+        }
+        *op++ = (uint8_t) length;
+        return op;
+      }
+
+      inline bool readLength(const uint8_t*& ip, const uint8_t* const iend, size_t& length) {
+        uint8_t s;
+        do {
+          if (ip >= iend) {
+            return false;
+          }
+          s = *ip++;
+          length += s;
+        } while (s == 255);
+        return true;
+      }
+    }
+
+    size_t compress(const void* src, const size_t srcSize, void* dst, const size_t dstCapacity) {
+      const uint8_t* const istart = (const uint8_t*) src;
+      const uint8_t* const iend = istart + srcSize;
+      const uint8_t* const mflimit = srcSize > kMatchFindLimit ? iend - kMatchFindLimit : istart;
+      const uint8_t* const matchlimit = srcSize > kLastLiterals ? iend - kLastLiterals : istart;
+      uint8_t* op = (uint8_t*) dst;
+      uint8_t* const oend = op + dstCapacity;
+
+      const uint8_t* ip = istart;
+      const uint8_t* anchor = istart;
+
+      uint32_t table[1 << kHashLog];
+      memset(table, 0, sizeof(table));
+
+      if (srcSize > kMatchFindLimit) {
+        table[hash(read32(ip))] = 0;
+        ++ip;
+        uint32_t searchCount = 1 << kSkipTrigger;
+        while (ip < mflimit) {
+          const uint32_t sequence = read32(ip);
+          const uint32_t h = hash(sequence);
+          const uint8_t* ref = istart + table[h];
+          table[h] = (uint32_t) (ip - istart);
+          if ((size_t) (ip - ref) > kMaxDistance || read32(ref) != sequence) {
+            ip += searchCount++ >> kSkipTrigger;
+            continue;
+          }
+          searchCount = 1 << kSkipTrigger;
+
+          // Extend the match backwards into pending literals
+          while (ip > anchor && ref > istart && ip[-1] == ref[-1]) {
+            --ip;
+            --ref;
+          }
+          // And forwards
+          const uint8_t* matchEnd = ip + kMinMatch;
+          const uint8_t* refEnd = ref + kMinMatch;
+          while (matchEnd < matchlimit && *matchEnd == *refEnd) {
+            ++matchEnd;
+            ++refEnd;
+          }
+
+          const size_t literalLength = ip - anchor;
+          const size_t matchLength = (matchEnd - ip) - kMinMatch;
+          // Token, literals, their length bytes, offset and match length bytes
+          if (op + 1 + literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1 > oend) {
+            return 0;
+          }
+          uint8_t* const token = op++;
+          *token = (uint8_t) ((literalLength >= 15 ? 15 : literalLength) << 4);
+          if (literalLength >= 15) {
+            op = writeLength(op, literalLength - 15);
+          }
+          if (literalLength > 0) {
+            memcpy(op, anchor, literalLength);
+            op += literalLength;
+          }
+          const uint16_t offset = (uint16_t) (ip - ref);
+          *op++ = (uint8_t) offset;
+          *op++ = (uint8_t) (offset >> 8);
+          *token |= (uint8_t) (matchLength >= 15 ? 15 : matchLength);
+          if (matchLength >= 15) {
+            op = writeLength(op, matchLength - 15);
+          }
+
+          ip = matchEnd;
+          anchor = ip;
+          if (ip < mflimit) {
+            // Seed the table with a position inside the match for a better ratio
+            table[hash(read32(ip - 2))] = (uint32_t) (ip - 2 - istart);
+          }
+        }
+      }
+
+      // Trailing literals
+      const size_t literalLength = iend - anchor;
+      if (op + 1 + literalLength + literalLength / 255 + 1 > oend) {
+        return 0;
+      }
+      uint8_t* const token = op++;
+      *token = (uint8_t) ((literalLength >= 15 ? 15 : literalLength) << 4);
+      if (literalLength >= 15) {
+        op = writeLength(op, literalLength - 15);
+      }
+      // Empty input may come with a null src, which memcpy must never see
+      if (literalLength > 0) {
+        memcpy(op, anchor, literalLength);
+        op += literalLength;
+      }
+
+      return op - (uint8_t*) dst;
+    }
+
+    bool decompress(const void* src, const size_t srcSize, void* dst, const size_t dstSize) {
+      const uint8_t* ip = (const uint8_t*) src;
+      const uint8_t* const iend = ip + srcSize;
+      uint8_t* const ostart = (uint8_t*) dst;
+      uint8_t* op = ostart;
+      uint8_t* const oend = op + dstSize;
+
+      while (ip < iend) {
+        const uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(ip, iend, literalLength)) {
+          return false;
+        }
+        if (literalLength > (size_t) (iend - ip) || literalLength > (size_t) (oend - op)) {
+          return false;
+        }
+        if (literalLength > 0) {
+          memcpy(op, ip, literalLength);
+          ip += literalLength;
+          op += literalLength;
+        }
+
+        // The last sequence only carries literals
+        if (ip == iend) {
+          break;
+        }
+
+        if (iend - ip < 2) {
+          return false;
+        }
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (size_t) (op - ostart)) {
+          return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, iend, matchLength)) {
+          return false;
+        }
+        matchLength += kMinMatch;
+        if (matchLength > (size_t) (oend - op)) {
+          return false;
+        }
+
+        // Overlapping matches repeat the last offset bytes. Copying in
+        // chunks that double in size keeps source and destination apart
+        // while still turning short periods into a handful of memcpys.
+        const uint8_t* const ref = op - offset;
+        size_t distance = offset;
+        while (matchLength > 0) {
+          const size_t chunk = matchLength < distance ? matchLength : distance;
+          memcpy(op, op - distance, chunk);
+          op += chunk;
+          matchLength -= chunk;
+          distance = op - ref;
+        }
+      }
+
+      return op == oend;
+    }
+  }
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bridge_util {
+
+  // Dependency free, LZ4 block format compatible lossless codec used for
+  // large upload payloads sent through the data queue. Favors speed over
+  // ratio: a single probe per position into a small hash table, with the
+  // search step growing over incompressible stretches.
+  namespace Compression {
+    // Worst case size of the compressed output for srcSize bytes of input
+    inline size_t compressBound(const size_t srcSize) {
+      return srcSize + srcSize / 255 + 16;
+    }
+
+    // Compresses src into dst. Returns the compressed size, or 0 if the
+    // output did not fit into dstCapacity, in which case the caller should
+    // send the data uncompressed.
+    size_t compress(const void* src, size_t srcSize, void* dst, size_t dstCapacity);
+
+    // Decompresses src into dst, which must be exactly dstSize bytes. Returns
+    // false if the input is malformed or does not decompress to dstSize.
+    bool decompress(const void* src, size_t srcSize, void* dst, size_t dstSize);
+  }
+
+}
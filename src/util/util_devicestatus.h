@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace bridge_util {
+
+  // Slowly changing device facts that the server publishes into a small
+  // shared memory block, so that the client can answer queries games like to
+  // poll every frame without a synchronous round trip to the server.
+  //
+  // The server republishes on every Present and after processing any command
+  // that may change the published values, bumping the invalidation epoch in
+  // the latter case. The client counts the invalidating commands it has sent
+  // and only trusts the published values once the server has caught up with
+  // all of them. Each device gets a slot of its own, keyed by the handle the
+  // client created it with.
+  class DeviceStatus {
+  public:
+    // Display mode of the implicit swap chain, mirrors D3DDISPLAYMODEEX
+    // and D3DDISPLAYROTATION
+    struct DisplayMode {
+      uint32_t width;
+      uint32_t height;
+      uint32_t refreshRate;
+      uint32_t format;
+      uint32_t scanLineOrdering;
+      uint32_t rotation;
+    };
+
+    // Status of one device. The slot is claimed by the server for a device
+    // handle and only read by the client for that same handle, so that one
+    // device never answers from another device's status.
+    struct DeviceSlot {
+      // Client handle of the owning device, zero while the slot is free
+      std::atomic<uint32_t> deviceHandle;
+      std::atomic<uint32_t> availableTextureMem;
+      std::atomic<uint32_t> bAvailableTextureMemValid;
+      // Sequence lock guarding displayMode: odd while being written, zero
+      // until the display mode has been published for the first time
+      std::atomic<uint32_t> displayModeSeq;
+      DisplayMode displayMode;
+      // HRESULT of CheckDeviceState() on the device window, updated whenever
+      // the device is lost or occluded on Present
+      std::atomic<uint32_t> deviceState;
+      std::atomic<uint32_t> bDeviceStateValid;
+    };
+
+    // Devices past this many go through the server for every query
+    static constexpr uint32_t kMaxDevices = 8;
+
+    struct Shared {
+      std::atomic<uint32_t> invalidationEpoch;
+      DeviceSlot devices[kMaxDevices];
+    };
+
+    static void init();
+
+    static bool isInitialized() {
+      return s_pShared != nullptr;
+    }
+
+    // Server side, only ever called from the device command thread
+    static void publishAvailableTextureMem(const uint32_t deviceHandle, const uint32_t availableTextureMem) {
+      if (DeviceSlot* const pSlot = claimSlot(deviceHandle)) {
+        pSlot->availableTextureMem.store(availableTextureMem, std::memory_order_relaxed);
+        pSlot->bAvailableTextureMemValid.store(1, std::memory_order_release);
+      }
+    }
+
+    static void publishDisplayMode(const uint32_t deviceHandle, const DisplayMode& displayMode) {
+      if (DeviceSlot* const pSlot = claimSlot(deviceHandle)) {
+        const uint32_t seq = pSlot->displayModeSeq.load(std::memory_order_relaxed);
+        pSlot->displayModeSeq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        pSlot->displayMode = displayMode;
+        pSlot->displayModeSeq.store(seq + 2, std::memory_order_release);
+      }
+    }
+
+    static void publishDeviceState(const uint32_t deviceHandle, const uint32_t deviceState) {
+      if (DeviceSlot* const pSlot = claimSlot(deviceHandle)) {
+        pSlot->deviceState.store(deviceState, std::memory_order_relaxed);
+        pSlot->bDeviceStateValid.store(1, std::memory_order_release);
+      }
+    }
+
+    // Frees the slot of a destroyed device
+    static void releaseDevice(const uint32_t deviceHandle) {
+      if (DeviceSlot* const pSlot = findSlot(deviceHandle)) {
+        pSlot->deviceHandle.store(0, std::memory_order_release);
+      }
+    }
+
+    static void onInvalidated() {
+      s_pShared->invalidationEpoch.fetch_add(1, std::memory_order_release);
+    }
+
+    // Client side
+    static void invalidate() {
+      s_clientEpoch.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static bool getAvailableTextureMem(const uint32_t deviceHandle, uint32_t& availableTextureMem) {
+      return read(deviceHandle, [&](const DeviceSlot& slot) {
+        if (!slot.bAvailableTextureMemValid.load(std::memory_order_acquire)) {
+          return false;
+        }
+        availableTextureMem = slot.availableTextureMem.load(std::memory_order_relaxed);
+        return true;
+      });
+    }
+
+    static bool getDeviceState(const uint32_t deviceHandle, uint32_t& deviceState) {
+      return read(deviceHandle, [&](const DeviceSlot& slot) {
+        if (!slot.bDeviceStateValid.load(std::memory_order_acquire)) {
+          return false;
+        }
+        deviceState = slot.deviceState.load(std::memory_order_relaxed);
+        return true;
+      });
+    }
+
+    static bool getDisplayMode(const uint32_t deviceHandle, DisplayMode& displayMode) {
+      return read(deviceHandle, [&](const DeviceSlot& slot) {
+        // The server only publishes a few times per frame, so retrying on a
+        // torn read is effectively never more than once
+        uint32_t seq;
+        do {
+          seq = slot.displayModeSeq.load(std::memory_order_acquire);
+          if (seq == 0) {
+            return false;
+          }
+          displayMode = slot.displayMode;
+          std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != slot.displayModeSeq.load(std::memory_order_relaxed));
+        return true;
+      });
+    }
+
+  private:
+    static DeviceSlot* findSlot(const uint32_t deviceHandle) {
+      for (DeviceSlot& slot : s_pShared->devices) {
+        if (slot.deviceHandle.load(std::memory_order_acquire) == deviceHandle) {
+          return &slot;
+        }
+      }
+      return nullptr;
+    }
+
+    static DeviceSlot* claimSlot(const uint32_t deviceHandle) {
+      if (DeviceSlot* const pSlot = findSlot(deviceHandle)) {
+        return pSlot;
+      }
+      DeviceSlot* const pSlot = findSlot(0);
+      if (pSlot != nullptr) {
+        // Nothing a previous owner published may be read as this device's
+        pSlot->bAvailableTextureMemValid.store(0, std::memory_order_relaxed);
+        pSlot->bDeviceStateValid.store(0, std::memory_order_relaxed);
+        pSlot->displayModeSeq.store(0, std::memory_order_relaxed);
+        pSlot->deviceHandle.store(deviceHandle, std::memory_order_release);
+      }
+      return pSlot;
+    }
+
+    // Runs the reader on the device's slot, and only trusts its result if the
+    // slot still belonged to the device afterwards
+    template<typename ReadFn>
+    static bool read(const uint32_t deviceHandle, const ReadFn& readFn) {
+      if (s_pShared->invalidationEpoch.load(std::memory_order_acquire) !=
+          s_clientEpoch.load(std::memory_order_relaxed)) {
+        return false;
+      }
+      const DeviceSlot* const pSlot = findSlot(deviceHandle);
+      if (pSlot == nullptr || !readFn(*pSlot)) {
+        return false;
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return pSlot->deviceHandle.load(std::memory_order_relaxed) == deviceHandle;
+    }
+
+    static Shared* s_pShared;
+    static std::atomic<uint32_t> s_clientEpoch;
+  };
+
+}
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "util_frametimeline.h"
+#include "util_sharedmemory.h"
+
+#include "config/global_options.h"
+#include "log/log.h"
+#include "../tracy/tracy.hpp"
+
+#include <windows.h>
+
+#include <algorithm>
+
+namespace bridge_util {
+
+  FrameTimeline::Shared* FrameTimeline::s_pShared = nullptr;
+  uint64_t FrameTimeline::s_frameNumber = 0;
+  bool FrameTimeline::s_bFrameStarted = false;
+  int64_t FrameTimeline::s_serverPoints[NumServerPoints] = {};
+
+  namespace {
+    // Latencies derived from the points of a frame
+    enum Span : uint32_t {
+      ClientSubmit,
+      ClientPresentCall,
+      FirstCommandQueueDelay,
+      ServerExecute,
+      PresentQueueDelay,
+      ServerPresent,
+      EndToEnd,
+      NumSpans
+    };
+
+    const char* const kSpanNames[NumSpans] = {
+      "Frame: client submit (ms)",
+      "Frame: client present (ms)",
+      "Frame: first command queue delay (ms)",
+      "Frame: server execute (ms)",
+      "Frame: present queue delay (ms)",
+      "Frame: server present (ms)",
+      "Frame: end to end (ms)",
+    };
+
+    struct SpanStats {
+      double total = 0.0;
+      double max = 0.0;
+    };
+
+    SpanStats gStats[NumSpans];
+    uint32_t gNumStatsFrames = 0;
+  }
+
+  void FrameTimeline::init() {
+    static SharedMemory sharedMem("FrameTimeline", sizeof(Shared));
+    s_pShared = static_cast<Shared*>(sharedMem.data());
+#ifdef REMIX_BRIDGE_CLIENT
+    // The client owns the ring, no slot holds a frame until it is published
+    for (auto& frame : s_pShared->frames) {
+      frame.frameNumber.store(UINT64_MAX, std::memory_order_relaxed);
+    }
+#endif
+  }
+
+  int64_t FrameTimeline::now() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+  }
+
+  void FrameTimeline::stampClient(const ClientPoint point) {
+    Frame& frame = s_pShared->frames[s_frameNumber % kNumFrames];
+    frame.points[point].store(now(), std::memory_order_relaxed);
+  }
+
+  void FrameTimeline::stampServer(const ServerPoint point) {
+    s_serverPoints[point] = now();
+  }
+
+  void FrameTimeline::onClientPresentSent(const int64_t presentTime) {
+    if (s_pShared == nullptr) {
+      return;
+    }
+    Frame& frame = s_pShared->frames[s_frameNumber % kNumFrames];
+    frame.points[ClientPresent].store(presentTime, std::memory_order_relaxed);
+    stampClient(ClientPresentSent);
+    frame.frameNumber.store(s_frameNumber, std::memory_order_release);
+
+    // The slot of the next frame is reused, invalidate it before writing
+    // any of its points
+    ++s_frameNumber;
+    Frame& nextFrame = s_pShared->frames[s_frameNumber % kNumFrames];
+    nextFrame.frameNumber.store(UINT64_MAX, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s_bFrameStarted = false;
+  }
+
+  void FrameTimeline::onServerPresentDone() {
+    if (s_pShared == nullptr) {
+      return;
+    }
+    stampServer(ServerPresentDone);
+
+    // The client may have moved on far enough to reuse the slot, in which
+    // case the frame is skipped
+    const Frame& frame = s_pShared->frames[s_frameNumber % kNumFrames];
+    int64_t clientPoints[NumClientPoints];
+    if (frame.frameNumber.load(std::memory_order_acquire) == s_frameNumber) {
+      for (uint32_t i = 0; i < NumClientPoints; ++i) {
+        clientPoints[i] = frame.points[i].load(std::memory_order_relaxed);
+      }
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (frame.frameNumber.load(std::memory_order_relaxed) == s_frameNumber) {
+        report(clientPoints);
+      }
+    }
+
+    ++s_frameNumber;
+    s_bFrameStarted = false;
+  }
+
+  void FrameTimeline::report(const int64_t (&clientPoints)[NumClientPoints]) {
+    static const double msPerTick = [] {
+      LARGE_INTEGER frequency;
+      QueryPerformanceFrequency(&frequency);
+      return 1000.0 / (double) frequency.QuadPart;
+    }();
+    const auto ms = [](const int64_t from, const int64_t to) {
+      return std::max(0.0, (double) (to - from) * msPerTick);
+    };
+
+    const double spans[NumSpans] = {
+      ms(clientPoints[ClientFirstCommand], clientPoints[ClientPresent]),
+      ms(clientPoints[ClientPresent], clientPoints[ClientPresentSent]),
+      ms(clientPoints[ClientFirstCommand], s_serverPoints[ServerFirstCommand]),
+      ms(s_serverPoints[ServerFirstCommand], s_serverPoints[ServerPresentPulled]),
+      ms(clientPoints[ClientPresentSent], s_serverPoints[ServerPresentPulled]),
+      ms(s_serverPoints[ServerPresentPulled], s_serverPoints[ServerPresentDone]),
+      ms(clientPoints[ClientFirstCommand], s_serverPoints[ServerPresentDone]),
+    };
+
+    for (uint32_t i = 0; i < NumSpans; ++i) {
+      TracyPlot(kSpanNames[i], spans[i]);
+      gStats[i].total += spans[i];
+      gStats[i].max = std::max(gStats[i].max, spans[i]);
+    }
+
+    static const uint32_t logInterval = GlobalOptions::getFrameTimelineLogInterval();
+    if (logInterval == 0 || ++gNumStatsFrames < logInterval) {
+      return;
+    }
+    std::string line = format_string("[FrameTimeline] Last %u frames, avg/max ms:", gNumStatsFrames);
+    for (uint32_t i = 0; i < NumSpans; ++i) {
+      // Strip the "Frame: " prefix and the unit of the plot names
+      std::string name = kSpanNames[i] + 7;
+      name.resize(name.size() - 5);
+      line += format_string(" %s %.2f/%.2f%s", name.c_str(), gStats[i].total / gNumStatsFrames,
+                            gStats[i].max, i + 1 < NumSpans ? "," : "");
+      gStats[i] = SpanStats();
+    }
+    Logger::info(line);
+    gNumStatsFrames = 0;
+  }
+
+}
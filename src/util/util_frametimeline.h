@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+
+namespace bridge_util {
+
+  // CPU timeline of each frame across both bridge processes, to tell apart
+  // time spent in the game, in client side marshaling, waiting in the queue
+  // and in server side execution.
+  //
+  // The key points of a frame are stamped with QueryPerformanceCounter, which
+  // is a monotonic clock shared by all processes on the machine. The client
+  // writes its points into a small shared memory ring indexed by frame. The
+  // server keeps its own points and, once it has finished a Present, combines
+  // them with the client's for the same frame into a latency breakdown that
+  // is plotted in Tracy and summarized in a periodic statistics log line.
+  //
+  // Both sides count frames by the Present commands they send and process,
+  // which keeps their frame numbers in lockstep.
+  class FrameTimeline {
+  public:
+    enum ClientPoint : uint32_t {
+      // First command of the frame started by the client
+      ClientFirstCommand,
+      // Present called by the game
+      ClientPresent,
+      // Present command, the last of the frame, issued by the client
+      ClientPresentSent,
+      NumClientPoints
+    };
+
+    enum ServerPoint : uint32_t {
+      // First command of the frame pulled by the server
+      ServerFirstCommand,
+      // Present command pulled by the server
+      ServerPresentPulled,
+      // Present returned on the server
+      ServerPresentDone,
+      NumServerPoints
+    };
+
+    static constexpr uint32_t kNumFrames = 16;
+
+    struct Frame {
+      // Number of the frame the client points belong to, written last
+      std::atomic<uint64_t> frameNumber;
+      std::atomic<int64_t> points[NumClientPoints];
+    };
+
+    struct Shared {
+      Frame frames[kNumFrames];
+    };
+
+    static void init();
+
+    static bool isInitialized() {
+      return s_pShared != nullptr;
+    }
+
+    // Client side
+    static void onClientCommand() {
+      if (s_pShared != nullptr && !s_bFrameStarted) {
+        s_bFrameStarted = true;
+        stampClient(ClientFirstCommand);
+      }
+    }
+
+    // Only reads the clock, the returned time is stamped into the frame by
+    // onClientPresentSent() under the writer lock
+    static int64_t onClientPresent() {
+      return s_pShared != nullptr ? now() : 0;
+    }
+
+    // Must be called inside the Present command's scope, where the writer
+    // lock serializes it with onClientCommand(), and before any of its data
+    // is sent, so that the frame is published by the time the server pulls it
+    static void onClientPresentSent(const int64_t presentTime);
+
+    // Server side
+    static void onServerCommand() {
+      if (s_pShared != nullptr && !s_bFrameStarted) {
+        s_bFrameStarted = true;
+        stampServer(ServerFirstCommand);
+      }
+    }
+
+    static void onServerPresentPulled() {
+      if (s_pShared != nullptr) {
+        stampServer(ServerPresentPulled);
+      }
+    }
+
+    static void onServerPresentDone();
+
+  private:
+    static int64_t now();
+    static void stampClient(const ClientPoint point);
+    static void stampServer(const ServerPoint point);
+    static void report(const int64_t (&clientPoints)[NumClientPoints]);
+
+    static Shared* s_pShared;
+    static uint64_t s_frameNumber;
+    static bool s_bFrameStarted;
+    static int64_t s_serverPoints[NumServerPoints];
+  };
+
+}
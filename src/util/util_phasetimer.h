@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "log/log.h"
+
+#include <chrono>
+#include <string>
+
+namespace bridge_util {
+
+  // Logs how long the enclosing scope took to execute. Used to attribute
+  // bridge startup time to its individual phases.
+  class ScopedPhaseTimer {
+  public:
+    ScopedPhaseTimer(const char* phaseName)
+      : m_phaseName(phaseName)
+      , m_start(std::chrono::high_resolution_clock::now()) {
+    }
+
+    ~ScopedPhaseTimer() {
+      const auto end = std::chrono::high_resolution_clock::now();
+      const auto us = std::chrono::duration_cast<std::chrono::microseconds>(end - m_start).count();
+      Logger::info(format_string("[Startup] %s took %.2f ms", m_phaseName, us / 1000.0));
+    }
+
+    ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+
+  private:
+    const char* m_phaseName;
+    const std::chrono::high_resolution_clock::time_point m_start;
+  };
+
+}
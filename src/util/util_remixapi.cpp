@@ -22,7 +22,9 @@
 
 #include "util_remixapi.h"
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstring>
 #include <type_traits>
 #include <typeinfo>
@@ -37,30 +39,76 @@ MaterialHandle::HandleMapT MaterialHandle::s_handleMap;
 MeshHandle::HandleMapT MeshHandle::s_handleMap;
 LightHandle::HandleMapT LightHandle::s_handleMap;
 #endif
+
+std::vector<DeserializeArena::Block> DeserializeArena::s_blocks;
+size_t DeserializeArena::s_offset = 0;
+
+void* DeserializeArena::alloc(const size_t size) {
+  const size_t alignedSize = (size + kAlignment - 1) & ~(kAlignment - 1);
+  if (s_blocks.empty() || s_offset + alignedSize > s_blocks.back().size) {
+    Block block;
+    block.size = std::max(alignedSize, s_blocks.empty() ? kDefaultBlockSize : s_blocks.back().size * 2);
+    block.pData = static_cast<uint8_t*>(_aligned_malloc(block.size, kAlignment));
+    s_blocks.push_back(block);
+    s_offset = 0;
+  }
+  void* const p = s_blocks.back().pData + s_offset;
+  s_offset += alignedSize;
+  return p;
+}
+
+void DeserializeArena::reset() {
+  if (s_blocks.size() > 1) {
+    size_t totalSize = 0;
+    for (auto& block : s_blocks) {
+      totalSize += block.size;
+      _aligned_free(block.pData);
+    }
+    s_blocks.clear();
+    Block block;
+    block.size = totalSize;
+    block.pData = static_cast<uint8_t*>(_aligned_malloc(block.size, kAlignment));
+    s_blocks.push_back(block);
+  }
+  s_offset = 0;
+}
 }
 }
 
 namespace {
 
 // Convenience function templates to help with the boilerplate necessary
-// to handle deserializing the `const T*` RemixApi struct member pattern
+// to handle deserializing the `const T*` RemixApi struct member pattern.
+// Memory is owned by the DeserializeArena and must not be deleted.
 
 template<typename T>
 static inline void deserialize_const_p(void*& pDeserialize, const T*& deserializeTo, const uint32_t size) {
-  T* new_arr = (T*) new uint8_t[size];
+  T* new_arr = (T*) remixapi::util::DeserializeArena::alloc(size);
   bridge_util::deserialize(pDeserialize, new_arr, size);
   deserializeTo = new_arr;
 }
 
 template<typename T>
 static inline void deserialize_const_p_for_each(void*& pDeserialize, const T*& deserializeTo, const size_t num) {
-  T* new_arr = (T*) new T[num];
+  T* new_arr = remixapi::util::DeserializeArena::alloc<T>(num);
   for(size_t i = 0; i < num; ++i) {
     bridge_util::deserialize(pDeserialize, new_arr[i]);
   }
   deserializeTo = new_arr;
 }
 
+// Points the member directly at the serialized bytes instead of copying them.
+// Only valid for trivially copyable element types whose serialized layout
+// matches their in-memory layout, and only for as long as the command's data
+// stays in the queue, i.e. until the server finishes processing the command.
+template<typename T>
+static inline void deserialize_const_p_view(void*& pDeserialize, const T*& deserializeTo, const uint32_t size) {
+  static_assert(std::is_trivially_copyable_v<T>);
+  assert((reinterpret_cast<uintptr_t>(pDeserialize) % alignof(T)) == 0);
+  deserializeTo = reinterpret_cast<const T*>(pDeserialize);
+  (reinterpret_cast<uintptr_t&>(pDeserialize)) += size;
+}
+
 }
 
 namespace bridge_util {
@@ -121,7 +169,7 @@ void deserialize(void*& deserializeFrom, remixapi_Path& deserializeTo) {
   if(bIsValidString) {
     const uint32_t size = pathSize(reinterpret_cast<const remixapi_Path&>(deserializeFrom));
     assert(size <= MAX_PATH);
-    auto intermediate = new wchar_t[size];
+    auto intermediate = (wchar_t*) remixapi::util::DeserializeArena::alloc(size);
     deserialize(deserializeFrom, intermediate, size);
     deserializeTo = intermediate;
   } else {
@@ -130,26 +178,27 @@ void deserialize(void*& deserializeFrom, remixapi_Path& deserializeTo) {
 }
 
 // remixapi_HardcodedVertex
+// Only the 36 bytes of actual vertex data go over the wire, the 28 bytes of
+// trailing padding don't. Those bytes lead the struct in one contiguous run,
+// so each vertex still moves with a single copy on both ends.
+static_assert(std::is_trivially_copyable_v<remixapi_HardcodedVertex>);
+static_assert(offsetof(remixapi_HardcodedVertex, position) == 0);
+static_assert(offsetof(remixapi_HardcodedVertex, normal) == 3 * sizeof(float));
+static_assert(offsetof(remixapi_HardcodedVertex, texcoord) == 6 * sizeof(float));
+static_assert(offsetof(remixapi_HardcodedVertex, color) == 8 * sizeof(float));
+static_assert(offsetof(remixapi_HardcodedVertex, _pad0) == 8 * sizeof(float) + sizeof(uint32_t));
 template<>
 static inline constexpr uint32_t sizeOf<remixapi_HardcodedVertex>() {
-  return sizeof(remixapi_HardcodedVertex::position)
-       + sizeof(remixapi_HardcodedVertex::normal)
-       + sizeof(remixapi_HardcodedVertex::texcoord)
-       + sizeof(remixapi_HardcodedVertex::color);
+  return offsetof(remixapi_HardcodedVertex, _pad0);
 }
 template<>
 void serialize(const remixapi_HardcodedVertex& serializeFrom, void*& pSerialize) {
-  serialize(&serializeFrom.position[0], pSerialize, sizeOf(serializeFrom.position));
-  serialize(&serializeFrom.normal[0], pSerialize, sizeOf(serializeFrom.normal));
-  serialize(&serializeFrom.texcoord[0], pSerialize, sizeOf(serializeFrom.texcoord));
-  serialize(&serializeFrom.color, pSerialize, sizeOf(serializeFrom.color));
+  serialize(&serializeFrom, pSerialize, sizeOf<remixapi_HardcodedVertex>());
 }
 template<>
 void deserialize(void*& deserializeFrom, remixapi_HardcodedVertex& deserializeTo) {
-  deserialize(deserializeFrom, &deserializeTo.position[0], sizeOf(deserializeTo.position));
-  deserialize(deserializeFrom, &deserializeTo.normal[0], sizeOf(deserializeTo.normal));
-  deserialize(deserializeFrom, &deserializeTo.texcoord[0], sizeOf(deserializeTo.texcoord));
-  deserialize(deserializeFrom, &deserializeTo.color, sizeOf(deserializeTo.color));
+  deserializeTo = {};
+  deserialize(deserializeFrom, &deserializeTo, sizeOf<remixapi_HardcodedVertex>());
 }
 
 // remixapi_*Handles
@@ -202,10 +251,7 @@ void MaterialInfo::_deserialize(void*& pDeserialize) {
   fold_helper::deserialize(pDeserialize, MaterialInfoVars);
 }
 void MaterialInfo::_dtor() {
-  delete albedoTexture;
-  delete normalTexture;
-  delete tangentTexture;
-  delete emissiveTexture;
+  // Deserialized members are owned by DeserializeArena
 }
 
 
@@ -240,9 +286,7 @@ void MaterialInfoOpaque::_deserialize(void*& pDeserialize) {
   fold_helper::deserialize(pDeserialize, MaterialInfoOpaqueVars);
 }
 void MaterialInfoOpaque::_dtor() {
-  delete roughnessTexture;
-  delete metallicTexture;
-  delete heightTexture;
+  // Deserialized members are owned by DeserializeArena
 }
 
 
@@ -265,9 +309,7 @@ void MaterialInfoOpaqueSubsurface::_deserialize(void*& pDeserialize) {
   fold_helper::deserialize(pDeserialize, MaterialInfoOpaqueSubsurfaceVars);
 }
 void MaterialInfoOpaqueSubsurface::_dtor() {
-  delete subsurfaceTransmittanceTexture;
-  delete subsurfaceThicknessTexture;
-  delete subsurfaceSingleScatteringAlbedoTexture;
+  // Deserialized members are owned by DeserializeArena
 }
 
 
@@ -290,7 +332,7 @@ void MaterialInfoTranslucent::_deserialize(void*& pDeserialize) {
   fold_helper::deserialize(pDeserialize, MaterialInfoTranslucentVars);
 }
 void MaterialInfoTranslucent::_dtor() {
-  delete transmittanceTexture;
+  // Deserialized members are owned by DeserializeArena
 }
 
 
@@ -411,11 +453,12 @@ template<>
 void deserialize(void*& pDeserialize, remixapi_MeshInfoSurfaceTriangles& surface) {
   // Vtxs
   bridge_util::deserialize(pDeserialize, surface.vertices_count);
+  // Unpacked into the arena, the wire layout lacks the padding
   deserialize_const_p_for_each(pDeserialize, surface.vertices_values, surface.vertices_count);
   // Idxs
   bridge_util::deserialize(pDeserialize, surface.indices_count);
   const size_t indicesSize = surface.indices_count * sizeof(uint32_t);
-  deserialize_const_p(pDeserialize, surface.indices_values, indicesSize);
+  deserialize_const_p_view(pDeserialize, surface.indices_values, indicesSize);
   // Skinning
   bridge_util::deserialize(pDeserialize, surface.skinning_hasvalue);
   if(surface.skinning_hasvalue) {
@@ -424,26 +467,17 @@ void deserialize(void*& pDeserialize, remixapi_MeshInfoSurfaceTriangles& surface
     // Blend Weights
     bridge_util::deserialize(pDeserialize, skinning.blendWeights_count);
     const size_t blendWeightsSize = surface.vertices_count * blendWeightSizePerVtx(skinning);
-    deserialize_const_p(pDeserialize, skinning.blendWeights_values, blendWeightsSize);
+    deserialize_const_p_view(pDeserialize, skinning.blendWeights_values, blendWeightsSize);
     // Blend Indices
     bridge_util::deserialize(pDeserialize, skinning.blendIndices_count);
     const size_t blendIndicesSize = surface.vertices_count * blendIndicesSizePerVtx(skinning);
-    deserialize_const_p(pDeserialize, skinning.blendIndices_values, blendIndicesSize);
+    deserialize_const_p_view(pDeserialize, skinning.blendIndices_values, blendIndicesSize);
   }
   bridge_util::deserialize(pDeserialize, surface.material);
 }
 
 void MeshInfo::_dtor() {
-  for(size_t nSurface = 0; nSurface < surfaces_count; ++nSurface) {
-    auto& surface = surfaces_values[nSurface];
-    delete surface.vertices_values;
-    delete surface.indices_values;
-    if(surface.skinning_hasvalue) {
-      auto& skinning = surface.skinning_value;
-      delete skinning.blendWeights_values;
-      delete skinning.blendIndices_values;
-    }
-  }
+  // Deserialized members are owned by DeserializeArena
 }
 
 //////////////////
@@ -534,7 +568,7 @@ void InstanceInfoTransforms::_deserialize(void*& pDeserialize) {
   deserialize_const_p_for_each(pDeserialize, boneTransforms_values, boneTransforms_count);
 }
 void InstanceInfoTransforms::_dtor() {
-  delete boneTransforms_values;
+  // Deserialized members are owned by DeserializeArena
 }
 
 
@@ -693,7 +727,7 @@ void LightInfoDome::_deserialize(void*& pDeserialize) {
   fold_helper::deserialize(pDeserialize, LightInfoDomeVars);
 }
 void LightInfoDome::_dtor() {
-  delete colorTexture;
+  // Deserialized members are owned by DeserializeArena
 }
 
 
@@ -778,19 +812,7 @@ void LightInfoUSD::_deserialize(void*& pDeserialize) {
   fold_deserialize__optionalPointer(pDeserialize, LightInfoUSDOptionalVars);
 }
 void LightInfoUSD::_dtor() {
-  if (pRadius) delete pRadius;
-  if (pWidth) delete pWidth;
-  if (pHeight) delete pHeight;
-  if (pLength) delete pLength;
-  if (pAngleRadians) delete pAngleRadians;
-  if (pEnableColorTemp) delete pEnableColorTemp;
-  if (pColor) delete pColor;
-  if (pColorTemp) delete pColorTemp;
-  if (pExposure) delete pExposure;
-  if (pIntensity) delete pIntensity;
-  if (pConeAngleRadians) delete pConeAngleRadians;
-  if (pConeSoftness) delete pConeSoftness;
-  if (pFocus) delete pFocus;
+  // Deserialized members are owned by DeserializeArena
 }
 
 }
\ No newline at end of file
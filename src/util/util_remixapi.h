@@ -28,6 +28,7 @@
 
 #include <typeinfo>
 #include <unordered_map>
+#include <vector>
 
 #define ASSERT_REMIXAPI_PFN_TYPE(REMIXAPI_FN_NAME) static_assert(std::is_same_v< decltype(&REMIXAPI_FN_NAME), PFN_##REMIXAPI_FN_NAME >)
 
@@ -82,6 +83,34 @@ using MaterialHandle = Handle<remixapi_MaterialHandle>;
 using MeshHandle = Handle<remixapi_MeshHandle>;
 using LightHandle = Handle<remixapi_LightHandle>;
 
+// Bump allocator that owns every variable-length member (arrays, paths,
+// optional values) of deserialized Remix API structs. Allocations are never
+// freed individually; instead the whole arena is reset once the Remix API
+// command that consumed them has completed. Only the server deserializes,
+// and only from the device command thread, so no locking is done here.
+class DeserializeArena {
+public:
+  static void* alloc(const size_t size);
+  template<typename T>
+  static T* alloc(const size_t num) {
+    return reinterpret_cast<T*>(alloc(num * sizeof(T)));
+  }
+  // Releases all allocations at once. If the previous command overflowed the
+  // current block, the blocks are merged into a single one large enough for
+  // that command, so steady state never has to touch the system allocator.
+  static void reset();
+
+private:
+  struct Block {
+    uint8_t* pData = nullptr;
+    size_t size = 0;
+  };
+  static constexpr size_t kAlignment = 16;
+  static constexpr size_t kDefaultBlockSize = 1 << 20;
+  static std::vector<Block> s_blocks;
+  static size_t s_offset;
+};
+
 struct AnyInfoPrototype {
   remixapi_StructType sType;
   void* pNext;
@@ -106,11 +106,15 @@ namespace bridge_util {
 #ifdef WITH_MULTITHREADED_DEVICE
 
 #define BRIDGE_DEVICE_LOCKGUARD() SCOPED_LOCK(this, true)
+// For code in a device base class, where only the virtual lock() reaches
+// the derived device's mutex
+#define BRIDGE_BASE_DEVICE_LOCKGUARD() SCOPED_LOCK(this, false)
 #define BRIDGE_PARENT_DEVICE_LOCKGUARD() SCOPED_LOCK(m_pDevice, false)
 
 #else // WITH_MULTITHREADED_DEVICE
 
 #define BRIDGE_DEVICE_LOCKGUARD()
+#define BRIDGE_BASE_DEVICE_LOCKGUARD()
 #define BRIDGE_PARENT_DEVICE_LOCKGUARD() 
 
 #endif // WITH_MULTITHREADED_DEVICE
\ No newline at end of file
@@ -20,6 +20,7 @@
  * DEALINGS IN THE SOFTWARE.
  */
 #include "util_seh.h"
+#include "util_commandhistory.h"
 #include "util_filesys.h"
 #include "log/log.h"
 
@@ -90,6 +91,8 @@ static LONG WINAPI BridgeExceptionHandler(PEXCEPTION_POINTERS pExceptionPointers
     SafeLog(LogLevel::Error, "CreateFile() failed with %d", GetLastError());
   }
 
+  CommandHistory::dump();
+
   // Trap it in debug
   assert(0 && "Unhandled exception thrown!");
 
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "util_validation.h"
+#include "util_commandhistory.h"
+#include "log/log.h"
+
+#include <atomic>
+#include <stdio.h>
+
+namespace bridge_util {
+
+  static std::atomic<uint32_t> s_numFailures = 0;
+
+  void onValidationFailure(const char* condition, const char* file, int line) {
+    // Failed checks tend to repeat every frame, so only the first few are logged
+    static constexpr uint32_t kMaxLoggedFailures = 16;
+
+    const uint32_t numFailures = s_numFailures.fetch_add(1);
+    if (numFailures >= kMaxLoggedFailures) {
+      return;
+    }
+
+    char msg[512];
+    snprintf(msg, sizeof(msg), "Validation failed: %s (%s:%d)", condition, file, line);
+    Logger::logLine(LogLevel::Error, msg);
+
+    if (numFailures == 0) {
+      CommandHistory::dump();
+    } else if (numFailures + 1 == kMaxLoggedFailures) {
+      Logger::logLine(LogLevel::Error, "Too many validation failures, further failures will not be logged.");
+    }
+  }
+
+  uint32_t getNumValidationFailures() {
+    return s_numFailures.load();
+  }
+
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+
+// Tiered runtime validation, selected at build time with the validation_level
+// meson option:
+//
+//   OFF   - no validation at all.
+//   CHEAP - only checks that boil down to a single well predicted branch on
+//           the hot paths, e.g. handle and size checks in command decoding.
+//           Meant to be left on in production builds.
+//   FULL  - additionally enables the more expensive checks, e.g. queue index
+//           bounds on every push and pull.
+//
+// A failed check logs the condition (rate limited) and dumps the command
+// history on the first failure, then carries on. Debug builds also assert.
+#define BRIDGE_VALIDATION_OFF   0
+#define BRIDGE_VALIDATION_CHEAP 1
+#define BRIDGE_VALIDATION_FULL  2
+
+#ifndef BRIDGE_VALIDATION_LEVEL
+#  ifdef NDEBUG
+#    define BRIDGE_VALIDATION_LEVEL BRIDGE_VALIDATION_CHEAP
+#  else
+#    define BRIDGE_VALIDATION_LEVEL BRIDGE_VALIDATION_FULL
+#  endif
+#endif
+
+namespace bridge_util {
+  // Kept out of line so that the checks themselves stay a compare and a branch
+  void onValidationFailure(const char* condition, const char* file, int line);
+
+  // Number of failed checks since startup, logged or not
+  uint32_t getNumValidationFailures();
+}
+
+#define BRIDGE_VALIDATE_IMPL(COND)                                      \
+  do {                                                                  \
+    if (!(COND)) {                                                      \
+      bridge_util::onValidationFailure(#COND, __FILE__, __LINE__);      \
+      assert(!#COND);                                                   \
+    }                                                                   \
+  } while (0)
+
+#if BRIDGE_VALIDATION_LEVEL >= BRIDGE_VALIDATION_CHEAP
+#define BRIDGE_VALIDATE_CHEAP(COND) BRIDGE_VALIDATE_IMPL(COND)
+#else
+#define BRIDGE_VALIDATE_CHEAP(COND) ((void)0)
+#endif
+
+#if BRIDGE_VALIDATION_LEVEL >= BRIDGE_VALIDATION_FULL
+#define BRIDGE_VALIDATE_FULL(COND) BRIDGE_VALIDATE_IMPL(COND)
+#else
+#define BRIDGE_VALIDATE_FULL(COND) ((void)0)
+#endif
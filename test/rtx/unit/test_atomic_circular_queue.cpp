@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "util_circularqueue.h"
+#include "util_commands.h"
+#include "config/global_options.h"
+
+#include <atomic>
+#include <new>
+#include <thread>
+
+#include "util_atomiccircularqueue.h"
+
+// Single producer, single consumer stress test of AtomicCircularQueue. Both
+// ends run on their own thread over one heap-backed queue, the consumer
+// checks that every element arrives exactly once, in order and untorn, and
+// that lookahead never sees past what the producer has published.
+
+using namespace bridge_util;
+
+namespace {
+  struct Element {
+    uint32_t seq;
+    uint32_t check;
+    uint64_t payload;
+  };
+
+  Element makeElement(const uint32_t seq) {
+    return { seq, ~seq, (uint64_t) seq * 0x9E3779B97F4A7C15ull };
+  }
+
+  bool isExpected(const Element& element, const uint32_t seq) {
+    const Element expected = makeElement(seq);
+    return element.seq == expected.seq &&
+           element.check == expected.check &&
+           element.payload == expected.payload;
+  }
+
+  using Writer = AtomicCircularQueue<Element, Accessor::Writer>;
+  using Reader = AtomicCircularQueue<Element, Accessor::Reader>;
+
+  // Generous, only hit if one side gets stuck
+  constexpr DWORD kPullTimeoutMS = 10'000;
+  constexpr uint32_t kMaxLookahead = 8;
+
+  bool runStress(const size_t queueSize, const uint32_t numElements) {
+    const size_t memSize = Writer::getExtraMemoryRequirements() + queueSize * sizeof(Element);
+    void* const pMemory = ::operator new(memSize, std::align_val_t { 128 });
+
+    bool bSuccess = true;
+    {
+      // The writer lays out the shared memory, so it must exist first
+      Writer writer("StressTest", pMemory, memSize, queueSize);
+      Reader reader("StressTest", pMemory, memSize, queueSize);
+
+      std::atomic<bool> bProducerDone = false;
+      std::thread producer([&] {
+        for (uint32_t seq = 0; seq < numElements; ++seq) {
+          // push() gives up once the command timeout expires on a full queue
+          while (RESULT_FAILURE(writer.push(makeElement(seq)))) {
+          }
+        }
+        bProducerDone = true;
+      });
+
+      for (uint32_t seq = 0; seq < numElements; ++seq) {
+        const uint32_t ahead = seq % kMaxLookahead;
+        if (const Element* pAhead = reader.peekAhead(ahead)) {
+          if (seq + ahead >= numElements || !isExpected(*pAhead, seq + ahead)) {
+            printf("Queue size %zu: lookahead of %u at element %u saw a wrong element\n",
+                   queueSize, ahead, seq);
+            bSuccess = false;
+            break;
+          }
+        }
+        Result result = Result::Failure;
+        const Element& element = reader.pull(result, kPullTimeoutMS);
+        if (RESULT_FAILURE(result)) {
+          printf("Queue size %zu: timed out waiting for element %u\n", queueSize, seq);
+          bSuccess = false;
+          break;
+        }
+        if (!isExpected(element, seq)) {
+          printf("Queue size %zu: expected element %u, got %u\n", queueSize, seq, element.seq);
+          bSuccess = false;
+          break;
+        }
+      }
+
+      if (bSuccess && !reader.isEmpty()) {
+        printf("Queue size %zu: queue not empty after the last element\n", queueSize);
+        bSuccess = false;
+      }
+
+      // Let a producer stuck on a full queue run to completion
+      while (!bSuccess && !bProducerDone) {
+        if (!reader.isEmpty()) {
+          Result result;
+          reader.pull(result, kPullTimeoutMS);
+        }
+      }
+      producer.join();
+    }
+
+    ::operator delete(pMemory, std::align_val_t { 128 });
+    return bSuccess;
+  }
+}
+
+int main() {
+  // Smallest possible queue, the default command queue size, one where the
+  // consumer publishes in batches of 8 and one with full size batches
+  const size_t kQueueSizes[] = { 2, 5, 64, 1024 };
+  constexpr uint32_t kNumElements = 1'000'000;
+
+  bool bSuccess = true;
+  for (const size_t queueSize : kQueueSizes) {
+    if (runStress(queueSize, kNumElements)) {
+      printf("Queue size %zu: %u elements passed\n", queueSize, kNumElements);
+    } else {
+      bSuccess = false;
+    }
+  }
+  return bSuccess ? 0 : 1;
+}
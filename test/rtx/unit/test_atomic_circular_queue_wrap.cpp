@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "util_circularqueue.h"
+#include "util_commands.h"
+#include "config/global_options.h"
+
+#include <new>
+
+#include "util_atomiccircularqueue.h"
+
+// Single threaded tests of AtomicCircularQueue::peekAhead() across the end
+// of the ring. For every position the consumer can be at, the queue is
+// filled so that the producer wraps ahead of the consumer, then drained so
+// that the consumer wraps after it, and every lookahead distance is checked
+// against what was pushed after each step.
+
+using namespace bridge_util;
+
+namespace {
+  using Writer = AtomicCircularQueue<uint32_t, Accessor::Writer>;
+  using Reader = AtomicCircularQueue<uint32_t, Accessor::Reader>;
+
+  constexpr DWORD kPullTimeoutMS = 1'000;
+
+  // Checks every lookahead distance with numAvailable elements in the queue,
+  // the next of which is nextSeq
+  bool checkLookahead(const Reader& reader, const size_t queueSize,
+                      const uint32_t nextSeq, const uint32_t numAvailable) {
+    for (uint32_t ahead = 0; ahead < queueSize + 2; ++ahead) {
+      const uint32_t* const pAhead = reader.peekAhead(ahead);
+      if (ahead < numAvailable) {
+        if (pAhead == nullptr || *pAhead != nextSeq + ahead) {
+          printf("Queue size %zu: lookahead of %u from element %u with %u available saw %s\n",
+                 queueSize, ahead, nextSeq, numAvailable, pAhead ? "a wrong element" : "nothing");
+          return false;
+        }
+      } else if (pAhead != nullptr) {
+        printf("Queue size %zu: lookahead of %u from element %u with %u available saw past the producer\n",
+               queueSize, ahead, nextSeq, numAvailable);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool runWrap(const size_t queueSize, const uint32_t startPos) {
+    const size_t memSize = Writer::getExtraMemoryRequirements() + queueSize * sizeof(uint32_t);
+    void* const pMemory = ::operator new(memSize, std::align_val_t { 128 });
+
+    bool bSuccess = true;
+    {
+      Writer writer("WrapTest", pMemory, memSize, queueSize);
+      Reader reader("WrapTest", pMemory, memSize, queueSize);
+      // One slot always stays free to tell a full queue from an empty one
+      const uint32_t capacity = (uint32_t) queueSize - 1;
+
+      uint32_t nextPush = 0;
+      uint32_t nextPull = 0;
+      auto push = [&]() {
+        return RESULT_SUCCESS(writer.push(nextPush++));
+      };
+      auto pull = [&]() {
+        Result result = Result::Failure;
+        const uint32_t value = reader.pull(result, kPullTimeoutMS);
+        return RESULT_SUCCESS(result) && value == nextPull++;
+      };
+
+      // Move both ends to startPos. The consumer publishes the slots it is
+      // done with in batches, finding the queue empty publishes all of them,
+      // which the producer needs to fill the queue without blocking.
+      for (uint32_t i = 0; i < startPos && bSuccess; ++i) {
+        bSuccess = push() && pull();
+      }
+      bSuccess = bSuccess && reader.isEmpty() && checkLookahead(reader, queueSize, nextPull, 0);
+
+      // Fill the queue, the window now wraps unless startPos is 0
+      for (uint32_t i = 0; i < capacity && bSuccess; ++i) {
+        bSuccess = push() && checkLookahead(reader, queueSize, nextPull, i + 1);
+      }
+
+      // And drain it, the consumer wraps somewhere along the way
+      for (uint32_t i = 0; i < capacity && bSuccess; ++i) {
+        bSuccess = pull() && checkLookahead(reader, queueSize, nextPull, capacity - i - 1);
+      }
+
+      if (!bSuccess) {
+        printf("Queue size %zu: failed starting at position %u\n", queueSize, startPos);
+      } else if (!reader.isEmpty()) {
+        printf("Queue size %zu: queue not empty starting at position %u\n", queueSize, startPos);
+        bSuccess = false;
+      }
+    }
+
+    ::operator delete(pMemory, std::align_val_t { 128 });
+    return bSuccess;
+  }
+}
+
+int main() {
+  const size_t kQueueSizes[] = { 2, 3, 5, 8, 64 };
+
+  bool bSuccess = true;
+  for (const size_t queueSize : kQueueSizes) {
+    bool bQueueSuccess = true;
+    for (uint32_t startPos = 0; startPos < queueSize; ++startPos) {
+      bQueueSuccess = runWrap(queueSize, startPos) && bQueueSuccess;
+    }
+    if (bQueueSuccess) {
+      printf("Queue size %zu: lookahead across the wrap passed\n", queueSize);
+    }
+    bSuccess = bSuccess && bQueueSuccess;
+  }
+  return bSuccess ? 0 : 1;
+}
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "util_compression.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Round trip and malformed input tests of the upload compression codec.
+// Decompression runs on data coming from another process, so besides
+// round tripping every kind of input, it must reject or safely decode any
+// corruption of it without ever reading or writing out of bounds.
+
+using namespace bridge_util;
+
+namespace {
+  using Bytes = std::vector<uint8_t>;
+
+  int g_numFailures = 0;
+
+  void check(const bool bCondition, const char* const what, const size_t size) {
+    if (!bCondition) {
+      printf("FAILED: %s (%zu bytes)\n", what, size);
+      ++g_numFailures;
+    }
+  }
+
+  Bytes compress(const Bytes& src) {
+    Bytes compressed(Compression::compressBound(src.size()));
+    const size_t size = Compression::compress(src.data(), src.size(), compressed.data(), compressed.size());
+    compressed.resize(size);
+    return compressed;
+  }
+
+  void testRoundTrip(const Bytes& src, const char* const what) {
+    const Bytes compressed = compress(src);
+    check(!compressed.empty(), what, src.size());
+    // Exactly sized, so that any overrun trips the allocator's checks
+    Bytes decompressed(src.size());
+    const bool bSuccess = Compression::decompress(compressed.data(), compressed.size(),
+                                                  decompressed.data(), decompressed.size());
+    check(bSuccess && decompressed == src, what, src.size());
+  }
+
+  Bytes makeRandom(std::mt19937& rng, const size_t size) {
+    Bytes bytes(size);
+    for (auto& byte : bytes) {
+      byte = (uint8_t) rng();
+    }
+    return bytes;
+  }
+
+  Bytes makeRepeating(const size_t size, const size_t period) {
+    Bytes bytes(size);
+    for (size_t i = 0; i < size; ++i) {
+      bytes[i] = (uint8_t) ((i % period) * 37 + 1);
+    }
+    return bytes;
+  }
+
+  // Mostly compressible, like typical texture and buffer uploads
+  Bytes makeMixed(std::mt19937& rng, const size_t size) {
+    Bytes bytes(size);
+    size_t i = 0;
+    while (i < size) {
+      const size_t runLength = std::min<size_t>(size - i, 1 + rng() % 300);
+      const bool bNoise = (rng() % 4) == 0;
+      const uint8_t value = (uint8_t) rng();
+      for (size_t j = 0; j < runLength; ++j) {
+        bytes[i + j] = bNoise ? (uint8_t) rng() : value;
+      }
+      i += runLength;
+    }
+    return bytes;
+  }
+
+  void testRoundTrips() {
+    std::mt19937 rng(1234);
+
+    // Empty input, both with and without a buffer behind it
+    {
+      uint8_t compressed[16];
+      const size_t size = Compression::compress(nullptr, 0, compressed, sizeof(compressed));
+      check(size > 0, "empty input compresses", 0);
+      check(Compression::decompress(compressed, size, nullptr, 0), "empty input round trips", 0);
+    }
+    testRoundTrip(Bytes(), "empty vector");
+
+    // Below, at and around the minimum sizes the format has matches for
+    for (size_t size = 1; size <= 64; ++size) {
+      testRoundTrip(makeRandom(rng, size), "short random");
+      testRoundTrip(Bytes(size, 0xAB), "short run");
+    }
+
+    // Periods shorter than the minimum match length force overlapping copies
+    for (size_t period = 1; period <= 17; ++period) {
+      testRoundTrip(makeRepeating(4096, period), "repeating pattern");
+    }
+
+    // Long runs need the extra 255 length bytes for literals and matches
+    testRoundTrip(Bytes(1 << 20, 0), "long zero run");
+    testRoundTrip(makeRandom(rng, 1 << 20), "incompressible");
+    // Match offsets at the maximum distance and past it
+    {
+      Bytes bytes = makeRandom(rng, 0x30000);
+      memcpy(bytes.data() + 0xFFFF, bytes.data(), 0x1000);
+      memcpy(bytes.data() + 0x20000, bytes.data() + 0x1000, 0x1000);
+      testRoundTrip(bytes, "far matches");
+    }
+    for (int i = 0; i < 32; ++i) {
+      testRoundTrip(makeMixed(rng, 1 + rng() % (256 * 1024)), "mixed");
+    }
+  }
+
+  void testOutputTooSmall() {
+    std::mt19937 rng(5678);
+    const Bytes src = makeRandom(rng, 4096);
+    Bytes compressed(src.size() / 2);
+    check(Compression::compress(src.data(), src.size(), compressed.data(), compressed.size()) == 0,
+          "incompressible input does not fit half its size", src.size());
+    check(Compression::compress(src.data(), src.size(), nullptr, 0) == 0,
+          "no output space fails", src.size());
+  }
+
+  bool decompressTo(const Bytes& compressed, const size_t dstSize) {
+    Bytes decompressed(dstSize);
+    return Compression::decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size());
+  }
+
+  void testCorruptedInput() {
+    std::mt19937 rng(9012);
+    const Bytes src = makeMixed(rng, 64 * 1024);
+    const Bytes compressed = compress(src);
+
+    // Wrong expected sizes
+    check(!decompressTo(compressed, src.size() - 1), "shorter destination is rejected", src.size());
+    check(!decompressTo(compressed, src.size() + 1), "longer destination is rejected", src.size());
+    check(!decompressTo(Bytes(), src.size()), "empty input is rejected", src.size());
+
+    // Every truncation
+    for (size_t size = 0; size < compressed.size(); ++size) {
+      const Bytes truncated(compressed.begin(), compressed.begin() + size);
+      check(!decompressTo(truncated, src.size()), "truncated input is rejected", size);
+    }
+
+    // Handcrafted sequences
+    {
+      // Literal length pointing past the end of the input
+      const Bytes literalsPastEnd = { 0xF0, 0xFF, 0xFF, 0x10, 'a', 'b' };
+      check(!decompressTo(literalsPastEnd, 1024), "literal run past the input is rejected", 0);
+      // Literal length byte missing
+      const Bytes missingLength = { 0xF0 };
+      check(!decompressTo(missingLength, 1024), "missing length byte is rejected", 0);
+      // Zero offset
+      const Bytes zeroOffset = { 0x40, 'a', 'b', 'c', 'd', 0x00, 0x00, 0x10, 'e' };
+      check(!decompressTo(zeroOffset, 9), "zero offset is rejected", 0);
+      // Offset before the start of the output
+      const Bytes offsetBeforeStart = { 0x40, 'a', 'b', 'c', 'd', 0x05, 0x00, 0x10, 'e' };
+      check(!decompressTo(offsetBeforeStart, 9), "offset before the output is rejected", 0);
+      // Match running past the end of the output
+      const Bytes matchPastEnd = { 0x4F, 'a', 'b', 'c', 'd', 0x04, 0x00, 0xFF, 0x10, 'e' };
+      check(!decompressTo(matchPastEnd, 64), "match past the output is rejected", 0);
+      // Offset cut off
+      const Bytes missingOffset = { 0x40, 'a', 'b', 'c', 'd', 0x04 };
+      check(!decompressTo(missingOffset, 8), "cut off offset is rejected", 0);
+      // Well formed: "abcd" followed by a 5 byte match at offset 4, then "e"
+      const Bytes valid = { 0x41, 'a', 'b', 'c', 'd', 0x04, 0x00, 0x10, 'e' };
+      check(decompressTo(valid, 10), "well formed sequence decodes", 0);
+    }
+
+    // Random corruption must never be accepted with an out of bounds access,
+    // which the exactly sized buffers leave to the allocator's checks
+    for (int i = 0; i < 2000; ++i) {
+      Bytes corrupted = compressed;
+      const int numFlips = 1 + rng() % 8;
+      for (int j = 0; j < numFlips; ++j) {
+        corrupted[rng() % corrupted.size()] ^= (uint8_t) (1 + rng() % 255);
+      }
+      Bytes decompressed(src.size());
+      Compression::decompress(corrupted.data(), corrupted.size(), decompressed.data(), decompressed.size());
+    }
+    for (int i = 0; i < 2000; ++i) {
+      const Bytes garbage = makeRandom(rng, 1 + rng() % 256);
+      Bytes decompressed(1 + rng() % 4096);
+      Compression::decompress(garbage.data(), garbage.size(), decompressed.data(), decompressed.size());
+    }
+  }
+}
+
+int main() {
+  testRoundTrips();
+  testOutputTooSmall();
+  testCorruptedInput();
+  if (g_numFailures > 0) {
+    printf("%d check(s) failed\n", g_numFailures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
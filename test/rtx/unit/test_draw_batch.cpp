@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "draw_batch.h"
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tests where DrawBatch ends its batches: at the configured number of draws,
+// when another device draws, and when any other command is started. Batches
+// are captured through DrawBatch::setSend() instead of going to a server.
+// Like a real MultiDraw command, the capturing sender flushes the held
+// commands first, just as the Command constructor does, so that re-entering
+// the flush from inside a flush is covered as well.
+
+using namespace bridge_util;
+
+// Nothing in here talks to a server, the bridge is never brought up
+bool gbBridgeRunning = false;
+Guid gUniqueIdentifier;
+
+namespace {
+  constexpr uint32_t kMaxDraws = 4;
+
+  struct Event {
+    // Zero for commands other than a batch of draws
+    uint32_t numDraws;
+    uintptr_t deviceHandle;
+    std::vector<uint32_t> words;
+  };
+
+  std::mutex g_eventMutex;
+  std::vector<Event> g_events;
+
+  int g_numFailures = 0;
+
+  void check(const bool bCondition, const char* const what) {
+    if (!bCondition) {
+      printf("FAILED: %s\n", what);
+      ++g_numFailures;
+    }
+  }
+
+  // What the Command constructor does before a command is written
+  void flushHeldCommands() {
+    DrawBatch::flush();
+  }
+
+  void sendBatch(const uintptr_t deviceHandle, const uint32_t numDraws, const std::vector<uint32_t>& words) {
+    flushHeldCommands();
+    std::scoped_lock lock(g_eventMutex);
+    g_events.push_back({ numDraws, deviceHandle, words });
+  }
+
+  void startCommand(const uintptr_t deviceHandle) {
+    flushHeldCommands();
+    std::scoped_lock lock(g_eventMutex);
+    g_events.push_back({ 0, deviceHandle, {} });
+  }
+
+  void draw(const uintptr_t deviceHandle, const uint32_t seq) {
+    auto& words = DrawBatch::begin(deviceHandle);
+    words.push_back((uint32_t) deviceHandle);
+    words.push_back(seq);
+    DrawBatch::end();
+  }
+
+  bool isBatch(const Event& event, const uintptr_t deviceHandle, const uint32_t firstSeq, const uint32_t numDraws) {
+    if (event.numDraws != numDraws || event.deviceHandle != deviceHandle || event.words.size() != 2 * numDraws) {
+      return false;
+    }
+    for (uint32_t i = 0; i < numDraws; ++i) {
+      if (event.words[2 * i] != deviceHandle || event.words[2 * i + 1] != firstSeq + i) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void testMaxDraws() {
+    g_events.clear();
+    for (uint32_t i = 0; i < 2 * kMaxDraws + 2; ++i) {
+      draw(1, i);
+    }
+    check(g_events.size() == 2, "full batches are sent as soon as they fill up");
+    startCommand(1);
+    check(g_events.size() == 4, "a command flushes the partial batch ahead of itself");
+    if (g_events.size() == 4) {
+      check(isBatch(g_events[0], 1, 0, kMaxDraws), "first full batch");
+      check(isBatch(g_events[1], 1, kMaxDraws, kMaxDraws), "second full batch");
+      check(isBatch(g_events[2], 1, 2 * kMaxDraws, 2), "partial batch");
+      check(g_events[3].numDraws == 0, "command follows the partial batch");
+    }
+  }
+
+  void testDeviceSwitch() {
+    g_events.clear();
+    draw(1, 0);
+    draw(1, 1);
+    draw(2, 0);
+    check(g_events.size() == 1, "another device's draw ends the batch");
+    draw(2, 1);
+    draw(1, 2);
+    DrawBatch::flush();
+    check(g_events.size() == 3, "each device switch ends the batch");
+    if (g_events.size() == 3) {
+      check(isBatch(g_events[0], 1, 0, 2), "first device's batch");
+      check(isBatch(g_events[1], 2, 0, 2), "second device's batch");
+      check(isBatch(g_events[2], 1, 2, 1), "first device's batch after the switch");
+    }
+  }
+
+  void testNothingHeld() {
+    g_events.clear();
+    DrawBatch::flush();
+    startCommand(1);
+    check(g_events.size() == 1 && g_events[0].numDraws == 0, "nothing is sent without held draws");
+
+    // Exactly full batches leave nothing behind for the next command
+    g_events.clear();
+    for (uint32_t i = 0; i < kMaxDraws; ++i) {
+      draw(1, i);
+    }
+    startCommand(1);
+    check(g_events.size() == 2 && isBatch(g_events[0], 1, 0, kMaxDraws) && g_events[1].numDraws == 0,
+          "full batch is not sent twice");
+  }
+
+  void testConcurrentDevices() {
+    g_events.clear();
+    constexpr uint32_t kNumDraws = 100000;
+    auto drawLoop = [](const uintptr_t deviceHandle) {
+      for (uint32_t i = 0; i < kNumDraws; ++i) {
+        draw(deviceHandle, i);
+        if (i % 37 == 0) {
+          startCommand(deviceHandle);
+        }
+      }
+    };
+    std::thread thread1(drawLoop, 1);
+    std::thread thread2(drawLoop, 2);
+    thread1.join();
+    thread2.join();
+    DrawBatch::flush();
+
+    // Every draw arrives exactly once, in order, in a batch of its own device
+    uint32_t nextSeq[3] = { 0, 0, 0 };
+    bool bValid = true;
+    for (const Event& event : g_events) {
+      if (event.numDraws == 0) {
+        continue;
+      }
+      const uintptr_t deviceHandle = event.deviceHandle;
+      if ((deviceHandle != 1 && deviceHandle != 2) || event.numDraws > kMaxDraws ||
+          !isBatch(event, deviceHandle, nextSeq[deviceHandle], event.numDraws)) {
+        bValid = false;
+        break;
+      }
+      nextSeq[deviceHandle] += event.numDraws;
+    }
+    check(bValid, "concurrent batches hold one device's draws in order");
+    check(nextSeq[1] == kNumDraws && nextSeq[2] == kNumDraws, "no concurrent draw is lost");
+  }
+}
+
+int main() {
+  Config::setOption("client.batchDraws", "True");
+  Config::setOption("client.batchDrawsMaxDraws", std::to_string(kMaxDraws));
+  Config::init(Config::App::Client);
+  DrawBatch::setSend(&sendBatch);
+
+  testMaxDraws();
+  testDeviceSwitch();
+  testNothingHeld();
+  testConcurrentDevices();
+  if (g_numFailures > 0) {
+    printf("%d check(s) failed\n", g_numFailures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
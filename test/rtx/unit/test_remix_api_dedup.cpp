@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "remix_api_dedup.h"
+
+#include <cstdio>
+
+// Tests of the content keys and cache used to deduplicate Remix API objects.
+// Keys are assembled the way RemixApi_CreateMaterial does it: the serialized
+// material, then the sType and payload of each extension.
+
+using namespace remixapi;
+
+namespace {
+  struct Object;
+  using Handle = Object*;
+
+  enum : uint32_t {
+    kOpaqueExt = 1,
+    kTranslucentExt = 2
+  };
+
+  struct Payload {
+    float values[4];
+  };
+
+  DedupKey makeMaterialKey(const Payload& material, const uint32_t extSType, const Payload& ext) {
+    DedupKey key;
+    key.append(&material, sizeof(material));
+    key.append(&extSType, sizeof(extSType));
+    key.append(&ext, sizeof(ext));
+    return key;
+  }
+
+  Handle makeHandle(const uintptr_t value) {
+    return reinterpret_cast<Handle>(value);
+  }
+
+  int g_numFailures = 0;
+
+  void check(const bool bCondition, const char* const what) {
+    if (!bCondition) {
+      printf("FAILED: %s\n", what);
+      ++g_numFailures;
+    }
+  }
+
+  void testIdenticalContentsAlias() {
+    DedupCache<Handle> cache;
+    const Payload material = { 1.f, 2.f, 3.f, 4.f };
+    const Payload ext = { 5.f, 6.f, 7.f, 8.f };
+    const Handle handle = makeHandle(0x10);
+
+    check(cache.acquire(makeMaterialKey(material, kOpaqueExt, ext)) == nullptr, "empty cache misses");
+    cache.insert(makeMaterialKey(material, kOpaqueExt, ext), handle);
+    check(cache.acquire(makeMaterialKey(material, kOpaqueExt, ext)) == handle, "identical contents alias");
+
+    // One reference from insert(), one from acquire()
+    check(!cache.release(handle), "first release keeps the object");
+    check(cache.release(handle), "last release destroys the object");
+    check(cache.acquire(makeMaterialKey(material, kOpaqueExt, ext)) == nullptr, "released object is gone");
+  }
+
+  void testExtensionTypeIsPartOfKey() {
+    DedupCache<Handle> cache;
+    const Payload material = { 1.f, 2.f, 3.f, 4.f };
+    const Payload ext = { 5.f, 6.f, 7.f, 8.f };
+
+    const DedupKey opaqueKey = makeMaterialKey(material, kOpaqueExt, ext);
+    const DedupKey translucentKey = makeMaterialKey(material, kTranslucentExt, ext);
+    check(opaqueKey.hash != translucentKey.hash, "extension sType changes the hash");
+    check(opaqueKey.bytes != translucentKey.bytes, "extension sType changes the bytes");
+
+    cache.insert(makeMaterialKey(material, kOpaqueExt, ext), makeHandle(0x10));
+    check(cache.acquire(translucentKey) == nullptr, "same payload under another sType does not alias");
+  }
+
+  void testHashCollisionDoesNotAlias() {
+    DedupCache<Handle> cache;
+    const Payload a = { 1.f, 2.f, 3.f, 4.f };
+    const Payload b = { 4.f, 3.f, 2.f, 1.f };
+    const Handle handleA = makeHandle(0x10);
+    const Handle handleB = makeHandle(0x20);
+
+    DedupKey keyA;
+    keyA.append(&a, sizeof(a));
+    DedupKey keyB;
+    keyB.append(&b, sizeof(b));
+    // Force a collision
+    keyB.hash = keyA.hash;
+    DedupKey keyBAgain = keyB;
+
+    cache.insert(std::move(keyA), handleA);
+    check(cache.acquire(keyB) == nullptr, "colliding key with other contents misses");
+    // Left uncached, so its only reference is the caller's
+    cache.insert(std::move(keyB), handleB);
+    check(cache.acquire(keyBAgain) == nullptr, "colliding object stays uncached");
+    check(cache.release(handleB), "uncached object is destroyed on release");
+    check(cache.release(handleA), "cached object is destroyed on last release");
+  }
+}
+
+int main() {
+  testIdenticalContentsAlias();
+  testExtensionTypeIsPartOfKey();
+  testHashCollisionDoesNotAlias();
+  if (g_numFailures > 0) {
+    printf("%d check(s) failed\n", g_numFailures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
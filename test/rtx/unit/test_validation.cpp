@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+// Failed checks are what is under test here, they must not abort the test
+// in debug builds
+#ifndef NDEBUG
+#define NDEBUG
+#endif
+
+#include "util_validation.h"
+
+#include <cstdio>
+
+// Tests of the tiered validation macros at the validation level the tree is
+// built with: checks of an enabled tier evaluate their condition exactly once
+// and report each failure, checks of a disabled tier compile to nothing.
+
+using namespace bridge_util;
+
+namespace {
+  constexpr bool kCheapEnabled = BRIDGE_VALIDATION_LEVEL >= BRIDGE_VALIDATION_CHEAP;
+  constexpr bool kFullEnabled = BRIDGE_VALIDATION_LEVEL >= BRIDGE_VALIDATION_FULL;
+
+  int g_numFailures = 0;
+
+  void check(const bool bCondition, const char* const what) {
+    if (!bCondition) {
+      printf("FAILED: %s\n", what);
+      ++g_numFailures;
+    }
+  }
+
+  void testPassingChecks() {
+    const uint32_t numFailures = getNumValidationFailures();
+    int numEvaluations = 0;
+    BRIDGE_VALIDATE_CHEAP(++numEvaluations > 0);
+    check(numEvaluations == (kCheapEnabled ? 1 : 0), "cheap check evaluates its condition once when enabled");
+    numEvaluations = 0;
+    BRIDGE_VALIDATE_FULL(++numEvaluations > 0);
+    check(numEvaluations == (kFullEnabled ? 1 : 0), "full check evaluates its condition once when enabled");
+    check(getNumValidationFailures() == numFailures, "passing checks are not reported");
+  }
+
+  void testFailingChecks() {
+    uint32_t numFailures = getNumValidationFailures();
+    int numEvaluations = 0;
+    BRIDGE_VALIDATE_CHEAP(++numEvaluations < 0);
+    check(numEvaluations == (kCheapEnabled ? 1 : 0), "failing cheap check evaluates its condition once");
+    check(getNumValidationFailures() == numFailures + (kCheapEnabled ? 1 : 0), "failing cheap check is reported");
+
+    numFailures = getNumValidationFailures();
+    numEvaluations = 0;
+    BRIDGE_VALIDATE_FULL(++numEvaluations < 0);
+    check(numEvaluations == (kFullEnabled ? 1 : 0), "failing full check evaluates its condition once");
+    check(getNumValidationFailures() == numFailures + (kFullEnabled ? 1 : 0), "failing full check is reported");
+  }
+
+  void testRepeatedFailures() {
+    // Well past the number of failures that get logged, the rest must still
+    // be counted and must not stop execution
+    constexpr uint32_t kNumChecks = 100;
+    const uint32_t numFailures = getNumValidationFailures();
+    for (uint32_t i = 0; i < kNumChecks; ++i) {
+      BRIDGE_VALIDATE_CHEAP(i == kNumChecks);
+    }
+    check(getNumValidationFailures() == numFailures + (kCheapEnabled ? kNumChecks : 0), "every failure is counted");
+  }
+
+  void testMacrosAreStatements() {
+    // Must nest in an unbraced if/else like any other statement
+    int numEvaluations = 0;
+    if (numEvaluations == 0)
+      BRIDGE_VALIDATE_CHEAP(++numEvaluations > 0);
+    else
+      BRIDGE_VALIDATE_FULL(++numEvaluations > 0);
+    check(numEvaluations == (kCheapEnabled ? 1 : 0), "macros nest in if/else");
+  }
+}
+
+int main() {
+  printf("Validation level: %d\n", BRIDGE_VALIDATION_LEVEL);
+  testPassingChecks();
+  testFailingChecks();
+  testRepeatedFailures();
+  testMacrosAreStatements();
+  if (g_numFailures > 0) {
+    printf("%d check(s) failed\n", g_numFailures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}